@@ -13,36 +13,33 @@ void bidirectional_stream_copy( Socket& socket, string_view peer_name )
 {
   constexpr size_t buffer_size = 1048576;
 
-  EventLoop _eventloop {};
   FileDescriptor _input { STDIN_FILENO };
   FileDescriptor _output { STDOUT_FILENO };
-  ByteStream _outbound { buffer_size };
-  ByteStream _inbound { buffer_size };
+  ByteStream _outbound { buffer_size, ByteStream::Storage::Mirrored };
+  ByteStream _inbound { buffer_size, ByteStream::Storage::Mirrored };
   bool _outbound_shutdown { false };
   bool _inbound_shutdown { false };
 
+  // declared last, so it is destroyed first: the reads and writes it has in flight use the byte streams' memory
+  EventLoop _eventloop { EventLoop::Backend::IoUring };
+  _eventloop.register_memory( _outbound.memory() );
+  _eventloop.register_memory( _inbound.memory() );
+
   socket.set_blocking( false );
   _input.set_blocking( false );
   _output.set_blocking( false );
 
+  // The event loop does the reads and writes itself: each read lands in the space the byte stream reserves, and
+  // each write sends what the byte stream has buffered. With io_uring, the kernel does them straight into the
+  // byte streams' (registered) memory while the loop waits.
+
   // rule 1: read from stdin into outbound byte stream
-  _eventloop.add_rule(
+  _eventloop.add_read_rule(
     "read from stdin into outbound byte stream",
     _input,
-    Direction::In,
-    [&] {
-      string data;
-      data.resize( _outbound.writer().available_capacity() );
-      _input.read( data );
-      _outbound.writer().push( move( data ) );
-      if ( _input.eof() ) {
-        _outbound.writer().close();
-      }
-    },
-    [&] {
-      return !_outbound.has_error() and !_inbound.has_error() and ( _outbound.writer().available_capacity() > 0 )
-             and !_outbound.writer().is_closed();
-    },
+    [&] { return _outbound.writer().reserve( _outbound.writer().available_capacity() ); },
+    [&]( size_t bytes_read ) { _outbound.writer().commit( bytes_read ); },
+    [&] { return !_outbound.has_error() and !_inbound.has_error(); },
     [&] { _outbound.writer().close(); },
     [&] {
       cerr << "DEBUG: Outbound stream had error from source.\n";
@@ -51,23 +48,12 @@ void bidirectional_stream_copy( Socket& socket, string_view peer_name )
     } );
 
   // rule 2: read from outbound byte stream into socket
-  _eventloop.add_rule(
+  _eventloop.add_write_rule(
     "read from outbound byte stream into socket",
     socket,
-    Direction::Out,
-    [&] {
-      if ( _outbound.reader().bytes_buffered() ) {
-        _outbound.reader().pop( socket.write( _outbound.reader().peek() ) );
-      }
-      if ( _outbound.reader().is_finished() ) {
-        socket.shutdown( SHUT_WR );
-        _outbound_shutdown = true;
-        cerr << "DEBUG: Outbound stream to " << peer_name << " finished.\n";
-      }
-    },
-    [&] {
-      return _outbound.reader().bytes_buffered() or ( _outbound.reader().is_finished() and not _outbound_shutdown );
-    },
+    [&] { return _outbound.reader().peek_all(); },
+    [&]( size_t bytes_written ) { _outbound.reader().pop( bytes_written ); },
+    [] { return true; },
     [&] { _outbound.writer().close(); },
     [&] {
       cerr << "DEBUG: Outbound stream had error from destination.\n";
@@ -75,24 +61,24 @@ void bidirectional_stream_copy( Socket& socket, string_view peer_name )
       _inbound.set_error();
     } );
 
-  // rule 3: read from socket into inbound byte stream
   _eventloop.add_rule(
-    "read from socket into inbound byte stream",
+    "shut down socket once outbound byte stream is finished",
     socket,
-    Direction::In,
-    [&] {
-      string data;
-      data.resize( _inbound.writer().available_capacity() );
-      socket.read( data );
-      _inbound.writer().push( move( data ) );
-      if ( socket.eof() ) {
-        _inbound.writer().close();
-      }
-    },
+    Direction::Out,
     [&] {
-      return !_inbound.has_error() and !_outbound.has_error() and ( _inbound.writer().available_capacity() > 0 )
-             and !_inbound.writer().is_closed();
+      socket.shutdown( SHUT_WR );
+      _outbound_shutdown = true;
+      cerr << "DEBUG: Outbound stream to " << peer_name << " finished.\n";
     },
+    [&] { return _outbound.reader().is_finished() and not _outbound_shutdown; } );
+
+  // rule 3: read from socket into inbound byte stream
+  _eventloop.add_read_rule(
+    "read from socket into inbound byte stream",
+    socket,
+    [&] { return _inbound.writer().reserve( _inbound.writer().available_capacity() ); },
+    [&]( size_t bytes_read ) { _inbound.writer().commit( bytes_read ); },
+    [&] { return !_inbound.has_error() and !_outbound.has_error(); },
     [&] { _inbound.writer().close(); },
     [&] {
       cerr << "DEBUG: Inbound stream had error from source.\n";
@@ -101,24 +87,12 @@ void bidirectional_stream_copy( Socket& socket, string_view peer_name )
     } );
 
   // rule 4: read from inbound byte stream into stdout
-  _eventloop.add_rule(
+  _eventloop.add_write_rule(
     "read from inbound byte stream into stdout",
     _output,
-    Direction::Out,
-    [&] {
-      if ( _inbound.reader().bytes_buffered() ) {
-        _inbound.reader().pop( _output.write( _inbound.reader().peek() ) );
-      }
-      if ( _inbound.reader().is_finished() ) {
-        _output.close();
-        _inbound_shutdown = true;
-        cerr << "DEBUG: Inbound stream from " << peer_name << " finished"
-             << ( _inbound.has_error() ? " uncleanly.\n" : ".\n" );
-      }
-    },
-    [&] {
-      return _inbound.reader().bytes_buffered() or ( _inbound.reader().is_finished() and not _inbound_shutdown );
-    },
+    [&] { return _inbound.reader().peek_all(); },
+    [&]( size_t bytes_written ) { _inbound.reader().pop( bytes_written ); },
+    [] { return true; },
     [&] { _inbound.writer().close(); },
     [&] {
       cerr << "DEBUG: Inbound stream had error from destination.\n";
@@ -126,6 +100,18 @@ void bidirectional_stream_copy( Socket& socket, string_view peer_name )
       _inbound.set_error();
     } );
 
+  _eventloop.add_rule(
+    "close stdout once inbound byte stream is finished",
+    _output,
+    Direction::Out,
+    [&] {
+      _output.close();
+      _inbound_shutdown = true;
+      cerr << "DEBUG: Inbound stream from " << peer_name << " finished"
+           << ( _inbound.has_error() ? " uncleanly.\n" : ".\n" );
+    },
+    [&] { return _inbound.reader().is_finished() and not _inbound_shutdown; } );
+
   // loop until completion
   while ( true ) {
     if ( EventLoop::Result::Exit == _eventloop.wait_next_event( -1 ) ) {
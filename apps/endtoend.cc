@@ -7,6 +7,7 @@
 #include "tcp_over_ip.hh"
 
 #include <cstdlib>
+#include <deque>
 #include <iostream>
 #include <thread>
 #include <utility>
@@ -73,9 +74,7 @@ optional<EthernetFrame> maybe_receive_frame( FileDescriptor& fd )
   fd.read( strs );
 
   EthernetFrame frame;
-  vector<string> buffers;
-  ranges::transform( strs, back_inserter( buffers ), identity() );
-  if ( not parse( frame, buffers ) ) {
+  if ( not parse( frame, BufferList { std::move( strs ) } ) ) {
     return {};
   }
 
@@ -100,6 +99,16 @@ private:
     {
       sockets.first.write( serialize( x ) );
     }
+
+    void transmit_batch( const NetworkInterface& n [[maybe_unused]], span<const EthernetFrame> frames ) override
+    {
+      vector<BufferList> dgrams;
+      dgrams.reserve( frames.size() );
+      for ( const auto& x : frames ) {
+        dgrams.push_back( serialize( x ) );
+      }
+      sockets.first.write_datagrams( dgrams );
+    }
   };
 
   shared_ptr<Sender> sender_ = make_shared<Sender>();
@@ -186,16 +195,30 @@ void program_body( bool is_client, const string& bounce_host, const string& boun
   class FramesOut : public NetworkInterface::OutputPort
   {
   public:
-    std::queue<EthernetFrame> frames {};
+    std::deque<EthernetFrame> frames {};
     void transmit( const NetworkInterface& n [[maybe_unused]], const EthernetFrame& x ) override
     {
-      frames.push( x );
+      frames.push_back( x );
     }
   };
 
   auto router_to_host = make_shared<FramesOut>();
   auto router_to_internet = make_shared<FramesOut>();
 
+  // Send every queued frame as its own datagram, with as few system calls as possible
+  auto flush_frames = [&]( FileDescriptor& fd, FramesOut& out, string_view label ) {
+    vector<BufferList> dgrams;
+    dgrams.reserve( out.frames.size() );
+    for ( const auto& frame : out.frames ) {
+      if ( debug ) {
+        cerr << "     " << label << summary( frame ) << "\n";
+      }
+      dgrams.push_back( serialize( frame ) );
+    }
+    const size_t sent = fd.write_datagrams( dgrams );
+    out.frames.erase( out.frames.begin(), out.frames.begin() + static_cast<ptrdiff_t>( sent ) );
+  };
+
   UDPSocket internet_socket;
   Address bounce_address { bounce_host, bounce_port };
 
@@ -250,7 +273,6 @@ void program_body( bool is_client, const string& bounce_host, const string& boun
           cerr << "     Host->router:     " << summary( frame ) << "\n";
         }
         router.interface( host_side )->recv_frame( frame );
-        router.route();
       } );
 
       // Frames from router to host
@@ -258,14 +280,7 @@ void program_body( bool is_client, const string& bounce_host, const string& boun
         "frames from router to host",
         sock.adapter().frame_fd(),
         Direction::Out,
-        [&] {
-          auto& f = router_to_host;
-          if ( debug ) {
-            cerr << "     Router->host:     " << summary( f->frames.front() ) << "\n";
-          }
-          sock.adapter().frame_fd().write( serialize( f->frames.front() ) );
-          f->frames.pop();
-        },
+        [&] { flush_frames( sock.adapter().frame_fd(), *router_to_host, "Router->host:     " ); },
         [&] { return not router_to_host->frames.empty(); } );
 
       // Frames from router to Internet
@@ -273,14 +288,7 @@ void program_body( bool is_client, const string& bounce_host, const string& boun
         "frames from router to Internet",
         internet_socket,
         Direction::Out,
-        [&] {
-          auto& f = router_to_internet;
-          if ( debug ) {
-            cerr << "     Router->Internet: " << summary( f->frames.front() ) << "\n";
-          }
-          internet_socket.write( serialize( f->frames.front() ) );
-          f->frames.pop();
-        },
+        [&] { flush_frames( internet_socket, *router_to_internet, "Router->Internet: " ); },
         [&] { return not router_to_internet->frames.empty(); } );
 
       // Frames from Internet to router
@@ -294,7 +302,6 @@ void program_body( bool is_client, const string& bounce_host, const string& boun
           cerr << "     Internet->router: " << summary( frame ) << "\n";
         }
         router.interface( internet_side )->recv_frame( frame );
-        router.route();
       } );
 
       while ( true ) {
@@ -302,6 +309,8 @@ void program_body( bool is_client, const string& bounce_host, const string& boun
           cerr << "Exiting...\n";
           return;
         }
+        // route everything that arrived during this event-loop iteration in one go
+        router.route();
         router.interface( host_side )->tick( 10 );
         router.interface( internet_side )->tick( 10 );
 
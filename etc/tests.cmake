@@ -23,6 +23,10 @@ ttest(byte_stream_one_write)
 ttest(byte_stream_two_writes)
 ttest(byte_stream_many_writes)
 ttest(byte_stream_stress_test)
+ttest(byte_stream_reserve)
+ttest(byte_stream_peek_all)
+ttest(byte_stream_mirrored_fallback)
+ttest(byte_stream_concurrent)
 
 ttest(reassembler_single)
 ttest(reassembler_cap)
@@ -31,6 +35,7 @@ ttest(reassembler_dup)
 ttest(reassembler_holes)
 ttest(reassembler_overlapping)
 ttest(reassembler_win)
+ttest(reassembler_in_place)
 
 ttest(wrapping_integers_cmp)
 ttest(wrapping_integers_wrap)
@@ -38,6 +43,12 @@ ttest(wrapping_integers_unwrap)
 ttest(wrapping_integers_roundtrip)
 ttest(wrapping_integers_extra)
 
+ttest(checksum_kernels)
+ttest(checksum_incremental)
+ttest(tcp_checksum_serialize)
+
+ttest(eventloop_backends)
+
 ttest(recv_connect)
 ttest(recv_transmit)
 ttest(recv_window)
@@ -54,8 +65,13 @@ ttest(send_ack)
 ttest(send_close)
 ttest(send_extra)
 
+ttest(timer_wheel)
+ttest(arp_cache)
 ttest(net_interface)
+ttest(net_interface_pending)
 
+ttest(route_table)
+ttest(route_cache)
 ttest(router)
 
 add_custom_target (check0 COMMAND ${CMAKE_CTEST_COMMAND} --output-on-failure --stop-on-failure --timeout 12 -R 'webget|^byte_stream_')
@@ -68,9 +84,11 @@ add_custom_target (check2 COMMAND ${CMAKE_CTEST_COMMAND} --output-on-failure --s
 
 add_custom_target (check3 COMMAND ${CMAKE_CTEST_COMMAND} --output-on-failure --stop-on-failure --timeout 12 -R '^byte_stream_|^reassembler_|^wrapping|^recv|^send')
 
-add_custom_target (check5 COMMAND ${CMAKE_CTEST_COMMAND} --output-on-failure --stop-on-failure --timeout 12 -R '^net_interface')
+add_custom_target (check5 COMMAND ${CMAKE_CTEST_COMMAND} --output-on-failure --stop-on-failure --timeout 12 -R '^net_interface|^timer_wheel|^arp_cache')
+
+add_custom_target (check6 COMMAND ${CMAKE_CTEST_COMMAND} --output-on-failure --stop-on-failure --timeout 12 -R '^net_interface|^timer_wheel|^arp_cache|^route')
 
-add_custom_target (check6 COMMAND ${CMAKE_CTEST_COMMAND} --output-on-failure --stop-on-failure --timeout 12 -R '^net_interface|^router')
+add_custom_target (check_util COMMAND ${CMAKE_CTEST_COMMAND} --output-on-failure --stop-on-failure --timeout 12 -R '^checksum_|^tcp_checksum_|^eventloop_backends')
 
 ###
 
@@ -90,3 +108,8 @@ set_tests_properties(${compile_name_opt} PROPERTIES FIXTURES_SETUP compile_opt)
 
 stest(byte_stream_speed_test)
 stest(reassembler_speed_test)
+stest(bookkeeping_speed_test)
+stest(header_parse_speed_test)
+stest(checksum_speed_test)
+stest(route_lookup_speed_test)
+stest(eventloop_speed_test)
@@ -0,0 +1,135 @@
+#include "arp_cache.hh"
+
+#include <stdexcept>
+
+using namespace std;
+
+size_t ARPCache::home_slot( const uint32_t ip_address ) const
+{
+  // 乘法散列，同一子网的地址也能分散开
+  const uint64_t hash = static_cast<uint32_t>( ip_address * 0x9e3779b1U );
+  return ( hash * index_.size() ) >> 32;
+}
+
+size_t ARPCache::find_slot( const uint32_t ip_address ) const
+{
+  if ( index_.empty() ) {
+    return 0;
+  }
+  const size_t mask = index_.size() - 1;
+  for ( size_t i = home_slot( ip_address );; i = ( i + 1 ) & mask ) {
+    if ( index_[i].entry == EMPTY ) {
+      return index_.size();
+    }
+    if ( index_[i].ip_address == ip_address ) {
+      return i;
+    }
+  }
+}
+
+ARPCache::Neighbor* ARPCache::find( const uint32_t ip_address )
+{
+  const size_t slot = find_slot( ip_address );
+  return slot < index_.size() ? &entries_[index_[slot].entry].neighbor : nullptr;
+}
+
+void ARPCache::place( const Slot slot )
+{
+  const size_t mask = index_.size() - 1;
+  size_t i = home_slot( slot.ip_address );
+  while ( index_[i].entry != EMPTY ) {
+    i = ( i + 1 ) & mask;
+  }
+  index_[i] = slot;
+}
+
+void ARPCache::grow_index()
+{
+  vector<Slot> old = std::exchange( index_, vector<Slot>( max( index_.size() * 2, size_t { 16 } ), { 0, EMPTY } ) );
+  for ( const Slot& slot : old ) {
+    if ( slot.entry != EMPTY ) {
+      place( slot );
+    }
+  }
+}
+
+ARPCache::Neighbor& ARPCache::insert( const uint32_t ip_address )
+{
+  if ( find_slot( ip_address ) < index_.size() ) {
+    throw runtime_error( "ARPCache: neighbor already present" );
+  }
+  if ( ( size_ + 1 ) * 2 > index_.size() ) {
+    grow_index();
+  }
+
+  uint32_t entry {};
+  if ( free_entries_.empty() ) {
+    entry = entries_.size();
+    entries_.emplace_back();
+  } else {
+    entry = free_entries_.back();
+    free_entries_.pop_back();
+  }
+
+  entries_[entry].neighbor = { ip_address, {}, {}, 0, timers_.now() };
+  entries_[entry].in_use = true;
+  place( { ip_address, entry } );
+  ++size_;
+  return entries_[entry].neighbor;
+}
+
+void ARPCache::erase( const uint32_t ip_address )
+{
+  size_t hole = find_slot( ip_address );
+  if ( hole == index_.size() ) {
+    return;
+  }
+
+  Entry& entry = entries_[index_[hole].entry];
+  entry.neighbor = {};
+  entry.in_use = false;
+  ++entry.cookie; // 使该项已有的定时器失效
+  free_entries_.push_back( index_[hole].entry );
+  --size_;
+
+  // 线性探测的删除：把后面探测链上的项往前移填补空位，不留墓碑
+  const size_t mask = index_.size() - 1;
+  index_[hole].entry = EMPTY;
+  for ( size_t i = ( hole + 1 ) & mask; index_[i].entry != EMPTY; i = ( i + 1 ) & mask ) {
+    const size_t home = home_slot( index_[i].ip_address );
+    // 空位在 [home, i) 的循环区间内时才能移动
+    if ( ( ( i - home ) & mask ) >= ( ( i - hole ) & mask ) ) {
+      index_[hole] = index_[i];
+      index_[i].entry = EMPTY;
+      hole = i;
+    }
+  }
+}
+
+uint32_t ARPCache::entry_index( const Neighbor& neighbor ) const
+{
+  const size_t slot = find_slot( neighbor.ip_address );
+  if ( slot == index_.size() ) {
+    throw runtime_error( "ARPCache: unknown neighbor" );
+  }
+  return index_[slot].entry;
+}
+
+void ARPCache::expire_in( const Neighbor& neighbor, const uint64_t ms )
+{
+  const uint32_t entry = entry_index( neighbor );
+  timers_.schedule( timers_.now() + ms, entry, ++entries_[entry].cookie );
+}
+
+void ARPCache::tick( const uint64_t ms_since_last_tick, const function<void( Neighbor& )>& on_expire )
+{
+  timers_.advance( timers_.now() + ms_since_last_tick, [&]( const uint32_t entry, const uint32_t cookie ) {
+    // 只有最近一次设置的定时器有效
+    if ( entries_[entry].in_use and entries_[entry].cookie == cookie ) {
+      if ( on_expire ) {
+        on_expire( entries_[entry].neighbor );
+      }
+      erase( entries_[entry].neighbor.ip_address );
+    }
+  } );
+}
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <optional>
+#include <vector>
+
+#include "ethernet_header.hh"
+#include "ipv4_datagram.hh"
+#include "timer_wheel.hh"
+
+// The NetworkInterface's table of neighbors: IPv4 address -> Ethernet address, for neighbors that have been
+// resolved, plus the datagrams waiting on neighbors that are still being resolved.
+//
+// Neighbors live in a slab (a vector with a free list) and are found through an open-addressing hash index
+// with linear probing, so a lookup is a hash and (usually) one or two probes of a compact array. Every neighbor
+// has an expiry time driven by a TimerWheel, so tick() only touches the neighbors that actually expire.
+class ARPCache
+{
+public:
+  struct Neighbor
+  {
+    uint32_t ip_address {};
+    std::optional<EthernetAddress> ethernet_address {}; // empty while resolution is outstanding
+    std::deque<InternetDatagram> pending {};            // datagrams waiting for the Ethernet address
+    uint64_t pending_bytes {};                          // their total size
+    uint64_t requested_at {};                           // when resolution started (ms)
+  };
+
+  // The neighbor with this address, or nullptr. The pointer stays valid until the next insert(), erase() or tick().
+  Neighbor* find( uint32_t ip_address );
+
+  // Add an (unresolved) neighbor that is not in the table yet
+  Neighbor& insert( uint32_t ip_address );
+
+  // Forget a neighbor (dropping its pending datagrams)
+  void erase( uint32_t ip_address );
+
+  // (Re)set the time after which the neighbor is forgotten
+  void expire_in( const Neighbor& neighbor, uint64_t ms );
+
+  // Let time pass, forgetting every neighbor whose time is up (after passing it to `on_expire`, if set)
+  void tick( uint64_t ms_since_last_tick, const std::function<void( Neighbor& )>& on_expire = {} );
+
+  // Total time passed, in ms
+  uint64_t now() const { return timers_.now(); }
+
+  size_t size() const { return size_; }
+
+private:
+  struct Entry
+  {
+    Neighbor neighbor {};
+    uint32_t cookie {}; // bumped by each expire_in(), to tell stale timers apart
+    bool in_use {};
+  };
+
+  // A slot of the hash index: an address and the position of its Entry in the slab
+  struct Slot
+  {
+    uint32_t ip_address;
+    uint32_t entry;
+  };
+  static constexpr uint32_t EMPTY = UINT32_MAX;
+
+  std::vector<Entry> entries_ {};
+  std::vector<uint32_t> free_entries_ {};
+  std::vector<Slot> index_ {}; // size is zero or a power of two, kept at most half full
+  size_t size_ {};
+  TimerWheel timers_ {};
+
+  size_t home_slot( uint32_t ip_address ) const;
+  size_t find_slot( uint32_t ip_address ) const; // index_.size() if absent
+  void grow_index();
+  void place( Slot slot );
+  uint32_t entry_index( const Neighbor& neighbor ) const;
+};
@@ -1,9 +1,46 @@
 #include "byte_stream.hh"
-#include <cstring>
+#include "exception.hh"
+
+#include <algorithm>
+#include <bit>
 
 using namespace std;
 
-ByteStream::ByteStream( uint64_t capacity ) : capacity_( capacity ), buf_( capacity, '\0' ) {}
+// 环形缓冲区实际大小
+static uint64_t ring_size_for( uint64_t capacity, ByteStream::Storage storage )
+{
+  switch ( storage ) {
+    case ByteStream::Storage::PowerOfTwo:
+      return std::bit_ceil( capacity );
+    case ByteStream::Storage::Mirrored: {
+      const uint64_t page = MirroredBuffer::page_size();
+      return std::max( ( capacity + page - 1 ) / page, uint64_t { 1 } ) * page;
+    }
+    case ByteStream::Storage::Exact:
+      break;
+  }
+  return capacity;
+}
+
+ByteStream::ByteStream( uint64_t capacity, Storage storage )
+  : capacity_( capacity )
+  , ring_size_( ring_size_for( capacity, storage ) )
+  , mask_( std::has_single_bit( ring_size_ ) && storage != Storage::Exact ? ring_size_ - 1 : 0 )
+  , buf_( storage == Storage::Mirrored ? 0 : ring_size_, '\0' )
+{
+  if ( storage != Storage::Mirrored ) {
+    return;
+  }
+
+  try {
+    mirror_ = MirroredBuffer { ring_size_ };
+  } catch ( const unix_error& ) {
+    // 无法建立双重映射（如沙箱禁止 memfd_create 或 mmap）时退回 PowerOfTwo 模式
+    ring_size_ = ring_size_for( capacity, Storage::PowerOfTwo );
+    mask_ = std::has_single_bit( ring_size_ ) ? ring_size_ - 1 : 0;
+    buf_.assign( ring_size_, '\0' );
+  }
+}
 
 bool Writer::is_closed() const
 {
@@ -12,22 +49,40 @@ bool Writer::is_closed() const
 
 void Writer::push( string data )
 {
-  uint64_t dsize = std::min( available_capacity(), data.size() );
-  uint64_t tailsize = capacity_ - tail_;
-  if ( !has_error() && !is_closed() ) {
+  const auto spans = reserve( data.size() );
+  const uint64_t size1 = spans[0].size();
+  const uint64_t size2 = spans[1].size();
 
-    // 环形缓冲区通用写入逻辑（无需判断 head_ 和 tail_ 的相对位置）
-    uint64_t size1 = std::min( dsize, tailsize );
-    uint64_t size2 = dsize - size1;
+  // 环形缓冲区通用写入逻辑（无需判断 head_ 和 tail_ 的相对位置）
+  std::copy_n( data.data(), size1, spans[0].data() );
+  std::copy_n( data.data() + size1, size2, spans[1].data() );
 
-    std::memcpy( buf_.data() + tail_, data.data(), size1 );
-    std::memcpy( buf_.data(), data.data() + size1, size2 );
+  commit( size1 + size2 );
+}
 
-    tot_push_bytes_ += dsize;
-    size_ += dsize;
-    tail_ += dsize;
-    tail_ %= capacity_;
-  }
+std::array<std::span<char>, 2> Writer::reserve( uint64_t len )
+{
+  if ( has_error() || is_closed() )
+    return {};
+
+  uint64_t dsize = std::min( available_capacity(), len );
+  uint64_t size1 = std::min( dsize, contiguous_from( tail_ ) );
+
+  return { std::span<char>( storage() + tail_, size1 ), std::span<char>( storage(), dsize - size1 ) };
+}
+
+void Writer::commit( uint64_t len )
+{
+  if ( has_error() || is_closed() )
+    return;
+
+  uint64_t dsize = std::min( available_capacity(), len );
+  if ( !dsize )
+    return;
+
+  tot_push_bytes_ += dsize;
+  size_ += dsize;
+  tail_ = wrap( tail_ + dsize );
 }
 
 void Writer::close()
@@ -56,14 +111,17 @@ uint64_t Reader::bytes_popped() const
 }
 
 string_view Reader::peek() const
+{
+  return peek_all()[0];
+}
+
+array<string_view, 2> Reader::peek_all() const
 {
   if ( !size_ )
-    return string_view {};
+    return {};
 
-  uint64_t contiguous = ( head_ < tail_ ) ? ( tail_ - head_ ) : ( capacity_ - head_ );
-  return string_view( buf_.data() + head_, contiguous );
-  // 可以返回多个字节的数据😅😅😅
-  // return string_view(buf_.data(), 1);
+  uint64_t contiguous = std::min( size_, contiguous_from( head_ ) );
+  return { string_view( storage() + head_, contiguous ), string_view( storage(), size_ - contiguous ) };
 }
 
 void Reader::pop( uint64_t len )
@@ -72,8 +130,10 @@ void Reader::pop( uint64_t len )
     return;
 
   uint64_t t = std::min( len, size_ );
+  if ( !t )
+    return;
 
-  head_ = ( head_ + t ) % capacity_;
+  head_ = wrap( head_ + t );
   size_ -= t;
   tot_pop_bytes_ += t;
 }
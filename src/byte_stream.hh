@@ -1,6 +1,10 @@
 #pragma once
 
+#include "mirrored_buffer.hh"
+
+#include <array>
 #include <cstdint>
+#include <span>
 #include <string>
 #include <string_view>
 
@@ -10,7 +14,18 @@ class Writer;
 class ByteStream
 {
 public:
-  explicit ByteStream( uint64_t capacity );
+  // How the ring buffer is laid out in memory. The configured capacity (what the Writer sees as
+  // available_capacity) is the same in every mode.
+  enum class Storage
+  {
+    Exact,      // ring is exactly `capacity` bytes, positions wrap with a modulo
+    PowerOfTwo, // ring is `capacity` rounded up to a power of two, positions wrap with a bitmask
+    Mirrored,   // ring is `capacity` rounded up to whole pages, mapped twice back to back in virtual memory,
+                // so peek() always returns every buffered byte and reserve() always returns a single span
+                // (falls back to PowerOfTwo if the double mapping cannot be set up, e.g. in a sandbox)
+  };
+
+  explicit ByteStream( uint64_t capacity, Storage storage = Storage::Exact );
 
   // Helper functions (provided) to access the ByteStream's Reader and Writer interfaces
   Reader& reader();
@@ -21,17 +36,34 @@ public:
   void set_error() { error_ = true; };       // Signal that the stream suffered an error.
   bool has_error() const { return error_; }; // Has the stream had an error?
 
+  // The memory holding the ring (both halves of a Mirrored ring), which reserve() and peek_all() point into,
+  // e.g. to register it with EventLoop::register_memory(). Valid as long as the stream is not moved.
+  std::span<char> memory() { return { storage(), mirror_.empty() ? ring_size_ : 2 * ring_size_ }; }
+
 protected:
   // Please add any additional state to the ByteStream here, and not to the Writer and Reader interfaces.
-  uint64_t capacity_;
+  uint64_t capacity_;  // 用户可见的容量
+  uint64_t ring_size_; // 环形缓冲区实际大小（PowerOfTwo 模式下向上取整到 2 的幂）
+  uint64_t mask_;      // ring_size_ - 1（仅 PowerOfTwo 模式），Exact 模式为 0
   uint64_t size_ {};
   uint64_t tot_push_bytes_ {};
   uint64_t tot_pop_bytes_ {};
   bool error_ {};
   bool close_ { false };
   std::string buf_;
+  MirroredBuffer mirror_ {}; // Mirrored 模式下的存储（此时 buf_ 为空）
   uint64_t head_ {};
   uint64_t tail_ {};
+
+  // 位置回绕：ring_size_ 为 2 的幂时用掩码，否则用取模
+  uint64_t wrap( uint64_t pos ) const { return mask_ ? pos & mask_ : pos % ring_size_; }
+
+  // 环形缓冲区起始地址
+  char* storage() { return mirror_.empty() ? buf_.data() : mirror_.data(); }
+  const char* storage() const { return mirror_.empty() ? buf_.data() : mirror_.data(); }
+
+  // 从 pos 开始最多能连续访问多少字节（Mirrored 模式下整个环都是连续的）
+  uint64_t contiguous_from( uint64_t pos ) const { return mirror_.empty() ? ring_size_ - pos : ring_size_; }
 };
 
 class Writer : public ByteStream
@@ -40,6 +72,15 @@ public:
   void push( std::string data ); // Push data to stream, but only as much as available capacity allows.
   void close();                  // Signal that the stream has reached its ending. Nothing more will be written.
 
+  /*
+   * Zero-copy push: reserve() returns up to `len` bytes of writable space inside the stream's own buffer
+   * (as two spans, because the space may wrap around the end of the ring; the second span may be empty).
+   * The caller fills a prefix of that space and then calls commit() with the number of bytes written,
+   * which publishes them to the Reader. Nothing is reserved if the stream is closed or has an error.
+   */
+  std::array<std::span<char>, 2> reserve( uint64_t len );
+  void commit( uint64_t len ); // Publish `len` bytes written into the space returned by reserve()
+
   bool is_closed() const;              // Has the stream been closed?
   uint64_t available_capacity() const; // How many bytes can be pushed to the stream right now?
   uint64_t bytes_pushed() const;       // Total number of bytes cumulatively pushed to the stream
@@ -51,6 +92,10 @@ public:
   std::string_view peek() const; // Peek at the next bytes in the buffer
   void pop( uint64_t len );      // Remove `len` bytes from the buffer
 
+  // Peek at all buffered bytes: the contiguous part up to the end of the ring, then the part that
+  // wrapped around to its beginning (empty if the buffered bytes don't wrap).
+  std::array<std::string_view, 2> peek_all() const;
+
   bool is_finished() const;        // Is the stream finished (closed and fully popped)?
   uint64_t bytes_buffered() const; // Number of bytes currently buffered (pushed and not popped)
   uint64_t bytes_popped() const;   // Total number of bytes cumulatively popped from stream
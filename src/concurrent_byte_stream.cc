@@ -0,0 +1,149 @@
+#include "concurrent_byte_stream.hh"
+
+#include <algorithm>
+
+using namespace std;
+
+ConcurrentByteStream::ConcurrentByteStream( uint64_t capacity ) : capacity_( capacity ), buf_( capacity, '\0' ) {}
+
+void ConcurrentByteStream::set_error()
+{
+  error_.store( true, memory_order_release );
+  readable_event_.notify();
+  writable_event_.notify();
+}
+
+// 写端：只有写线程修改 tot_push_bytes_，读端的 tot_pop_bytes_ 用 acquire 读取
+bool ConcurrentByteStream::Writer::is_closed() const
+{
+  return close_.load( memory_order_relaxed );
+}
+
+uint64_t ConcurrentByteStream::Writer::available_capacity() const
+{
+  return capacity_ - ( tot_push_bytes_.load( memory_order_relaxed ) - tot_pop_bytes_.load( memory_order_acquire ) );
+}
+
+uint64_t ConcurrentByteStream::Writer::bytes_pushed() const
+{
+  return tot_push_bytes_.load( memory_order_relaxed );
+}
+
+array<span<char>, 2> ConcurrentByteStream::Writer::reserve( uint64_t len )
+{
+  if ( has_error() || is_closed() )
+    return {};
+
+  uint64_t dsize = min( available_capacity(), len );
+  if ( !dsize )
+    return {};
+
+  uint64_t tail = tot_push_bytes_.load( memory_order_relaxed ) % capacity_;
+  uint64_t size1 = min( dsize, capacity_ - tail );
+
+  return { span<char>( buf_.data() + tail, size1 ), span<char>( buf_.data(), dsize - size1 ) };
+}
+
+void ConcurrentByteStream::Writer::commit( uint64_t len )
+{
+  if ( has_error() || is_closed() )
+    return;
+
+  uint64_t dsize = min( available_capacity(), len );
+  if ( !dsize )
+    return;
+
+  // release：写入缓冲区的数据先于新的 tot_push_bytes_ 对读线程可见
+  tot_push_bytes_.store( tot_push_bytes_.load( memory_order_relaxed ) + dsize, memory_order_release );
+  readable_event_.notify();
+}
+
+void ConcurrentByteStream::Writer::push( string_view data )
+{
+  const auto spans = reserve( data.size() );
+  const uint64_t size1 = spans[0].size();
+  const uint64_t size2 = spans[1].size();
+
+  copy_n( data.data(), size1, spans[0].data() );
+  copy_n( data.data() + size1, size2, spans[1].data() );
+
+  commit( size1 + size2 );
+}
+
+void ConcurrentByteStream::Writer::close()
+{
+  close_.store( true, memory_order_release );
+  readable_event_.notify();
+}
+
+// 读端：只有读线程修改 tot_pop_bytes_，写端的 tot_push_bytes_ 用 acquire 读取
+bool ConcurrentByteStream::Reader::is_finished() const
+{
+  return close_.load( memory_order_acquire ) && !bytes_buffered();
+}
+
+uint64_t ConcurrentByteStream::Reader::bytes_buffered() const
+{
+  return tot_push_bytes_.load( memory_order_acquire ) - tot_pop_bytes_.load( memory_order_relaxed );
+}
+
+uint64_t ConcurrentByteStream::Reader::bytes_popped() const
+{
+  return tot_pop_bytes_.load( memory_order_relaxed );
+}
+
+string_view ConcurrentByteStream::Reader::peek() const
+{
+  return peek_all()[0];
+}
+
+array<string_view, 2> ConcurrentByteStream::Reader::peek_all() const
+{
+  uint64_t size = bytes_buffered();
+  if ( !size )
+    return {};
+
+  uint64_t head = tot_pop_bytes_.load( memory_order_relaxed ) % capacity_;
+  uint64_t contiguous = min( size, capacity_ - head );
+  return { string_view( buf_.data() + head, contiguous ), string_view( buf_.data(), size - contiguous ) };
+}
+
+void ConcurrentByteStream::Reader::pop( uint64_t len )
+{
+  if ( has_error() )
+    return;
+
+  uint64_t t = min( len, bytes_buffered() );
+  if ( !t )
+    return;
+
+  // release：读线程对这段缓冲区的读取先于写线程复用它
+  tot_pop_bytes_.store( tot_pop_bytes_.load( memory_order_relaxed ) + t, memory_order_release );
+  writable_event_.notify();
+}
+
+ConcurrentByteStream::Reader& ConcurrentByteStream::reader()
+{
+  static_assert( sizeof( Reader ) == sizeof( ConcurrentByteStream ),
+                 "Please add member variables to the ConcurrentByteStream base, not the Reader." );
+
+  return static_cast<Reader&>( *this ); // NOLINT(*-downcast)
+}
+
+const ConcurrentByteStream::Reader& ConcurrentByteStream::reader() const
+{
+  return static_cast<const Reader&>( *this ); // NOLINT(*-downcast)
+}
+
+ConcurrentByteStream::Writer& ConcurrentByteStream::writer()
+{
+  static_assert( sizeof( Writer ) == sizeof( ConcurrentByteStream ),
+                 "Please add member variables to the ConcurrentByteStream base, not the Writer." );
+
+  return static_cast<Writer&>( *this ); // NOLINT(*-downcast)
+}
+
+const ConcurrentByteStream::Writer& ConcurrentByteStream::writer() const
+{
+  return static_cast<const Writer&>( *this ); // NOLINT(*-downcast)
+}
@@ -0,0 +1,87 @@
+#pragma once
+
+#include "eventfd.hh"
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <string_view>
+
+/*
+ * A ByteStream that can be shared by exactly one writer thread and one reader thread without locks.
+ *
+ * It has the same Reader/Writer interface as ByteStream. The ring is indexed by the cumulative push/pop
+ * counters, each of which is only ever stored by one side (release) and loaded by the other (acquire), and
+ * which live on separate cache lines so the two threads don't false-share.
+ *
+ * Two eventfds let either side sleep in an EventLoop: `readable_event()` is notified whenever bytes are
+ * pushed or the stream is closed or errored, and `writable_event()` whenever bytes are popped. A rule on
+ * one of them should clear() it *before* looking at the stream, so that no wakeup is lost.
+ */
+class ConcurrentByteStream
+{
+public:
+  class Reader;
+  class Writer;
+
+  explicit ConcurrentByteStream( uint64_t capacity );
+
+  Reader& reader();
+  const Reader& reader() const;
+  Writer& writer();
+  const Writer& writer() const;
+
+  void set_error();     // Signal that the stream suffered an error (from either thread).
+  bool has_error() const { return error_.load( std::memory_order_acquire ); }
+
+  EventFD& readable_event() { return readable_event_; } // For the reader thread's EventLoop
+  EventFD& writable_event() { return writable_event_; } // For the writer thread's EventLoop
+
+  // Shared between threads by reference; never copied or moved.
+  ConcurrentByteStream( const ConcurrentByteStream& other ) = delete;
+  ConcurrentByteStream& operator=( const ConcurrentByteStream& other ) = delete;
+  ConcurrentByteStream( ConcurrentByteStream&& other ) = delete;
+  ConcurrentByteStream& operator=( ConcurrentByteStream&& other ) = delete;
+  ~ConcurrentByteStream() = default;
+
+protected:
+  static constexpr size_t CACHE_LINE_SIZE = 64;
+
+  // Please add any additional state here, and not to the Writer and Reader interfaces.
+  uint64_t capacity_;
+  std::string buf_;
+  alignas( CACHE_LINE_SIZE ) std::atomic<uint64_t> tot_push_bytes_ {}; // stored by the writer only
+  alignas( CACHE_LINE_SIZE ) std::atomic<uint64_t> tot_pop_bytes_ {};  // stored by the reader only
+  alignas( CACHE_LINE_SIZE ) std::atomic<bool> close_ {};
+  std::atomic<bool> error_ {};
+  EventFD readable_event_ {};
+  EventFD writable_event_ {};
+};
+
+class ConcurrentByteStream::Writer : public ConcurrentByteStream
+{
+public:
+  void push( std::string_view data ); // Push data to stream, but only as much as available capacity allows.
+  void close();                       // Signal that the stream has reached its ending.
+
+  std::array<std::span<char>, 2> reserve( uint64_t len ); // Zero-copy push (see Writer::reserve)
+  void commit( uint64_t len );
+
+  bool is_closed() const;              // Has the stream been closed?
+  uint64_t available_capacity() const; // How many bytes can be pushed to the stream right now?
+  uint64_t bytes_pushed() const;       // Total number of bytes cumulatively pushed to the stream
+};
+
+class ConcurrentByteStream::Reader : public ConcurrentByteStream
+{
+public:
+  std::string_view peek() const;                    // Peek at the next bytes in the buffer
+  std::array<std::string_view, 2> peek_all() const; // Peek at all buffered bytes (two segments if wrapped)
+  void pop( uint64_t len );                         // Remove `len` bytes from the buffer
+
+  bool is_finished() const;        // Is the stream finished (closed and fully popped)?
+  uint64_t bytes_buffered() const; // Number of bytes currently buffered (pushed and not popped)
+  uint64_t bytes_popped() const;   // Total number of bytes cumulatively popped from stream
+};
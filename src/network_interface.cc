@@ -1,3 +1,5 @@
+#include <algorithm>
+#include <bit>
 #include <iostream>
 
 #include "arp_message.hh"
@@ -27,21 +29,193 @@ NetworkInterface::NetworkInterface( string_view name,
 //! can be converted to a uint32_t (raw 32-bit IP address) by using the Address::ipv4_numeric() method.
 void NetworkInterface::send_datagram( const InternetDatagram& dgram, const Address& next_hop )
 {
-  // Your code here.
-  (void)dgram;
-  (void)next_hop;
+  send_datagrams( span { &dgram, 1 }, next_hop );
+}
+
+//! \param[in] dgrams the IPv4 datagrams to be sent, in order
+//! \param[in] next_hop the IP address of the interface to send all of them to
+void NetworkInterface::send_datagrams( span<const InternetDatagram> dgrams, const Address& next_hop )
+{
+  if ( dgrams.empty() ) {
+    return;
+  }
+
+  // 整批只查一次 ARP 缓存
+  const uint32_t next_hop_ip = next_hop.ipv4_numeric();
+  ARPCache::Neighbor* neighbor = arp_cache_.find( next_hop_ip );
+
+  if ( neighbor != nullptr and neighbor->ethernet_address.has_value() ) {
+    if ( dgrams.size() == 1 ) {
+      transmit( make_ipv4_frame( dgrams.front(), *neighbor->ethernet_address ) );
+      return;
+    }
+    vector<EthernetFrame> frames;
+    frames.reserve( dgrams.size() );
+    for ( const auto& dgram : dgrams ) {
+      frames.push_back( make_ipv4_frame( dgram, *neighbor->ethernet_address ) );
+    }
+    transmit_batch( frames );
+    return;
+  }
+
+  // 地址未知：数据报排队等待应答，5 秒内对同一下一跳只发一次 ARP 请求
+  const bool request = neighbor == nullptr;
+  if ( request ) {
+    neighbor = &arp_cache_.insert( next_hop_ip );
+    arp_cache_.expire_in( *neighbor, ARP_REQUEST_INTERVAL_MS );
+  }
+  for ( const auto& dgram : dgrams ) {
+    enqueue( *neighbor, dgram );
+  }
+
+  // 最后再发请求（应答可能在 transmit 中同步到达，并使 neighbor 失效）
+  if ( request ) {
+    send_arp( ARPMessage::OPCODE_REQUEST, ETHERNET_BROADCAST, next_hop_ip );
+  }
 }
 
 //! \param[in] frame the incoming Ethernet frame
 void NetworkInterface::recv_frame( const EthernetFrame& frame )
 {
-  // Your code here.
-  (void)frame;
+  if ( frame.header.dst != ethernet_address_ and frame.header.dst != ETHERNET_BROADCAST ) {
+    return;
+  }
+
+  switch ( frame.header.type ) {
+    case EthernetHeader::TYPE_IPv4: {
+      InternetDatagram dgram;
+      if ( parse( dgram, frame.payload ) ) {
+        datagrams_received_.push( move( dgram ) );
+      }
+    } break;
+
+    case EthernetHeader::TYPE_ARP: {
+      ARPMessage arp;
+      if ( not parse( arp, frame.payload ) or not arp.supported() ) {
+        return;
+      }
+      learn( arp.sender_ip_address, arp.sender_ethernet_address );
+      if ( arp.opcode == ARPMessage::OPCODE_REQUEST and arp.target_ip_address == ip_address_.ipv4_numeric() ) {
+        send_arp( ARPMessage::OPCODE_REPLY, arp.sender_ethernet_address, arp.sender_ip_address );
+      }
+    } break;
+
+    default:
+      break;
+  }
 }
 
 //! \param[in] ms_since_last_tick the number of milliseconds since the last call to this method
 void NetworkInterface::tick( const size_t ms_since_last_tick )
 {
-  // Your code here.
-  (void)ms_since_last_tick;
+  // 过期的映射和超时未应答的请求（连同排队的数据报）被删除
+  arp_cache_.tick( ms_since_last_tick, [&]( const ARPCache::Neighbor& neighbor ) {
+    pending_stats_.dropped_unresolved += neighbor.pending.size();
+    pending_stats_.packets_pending -= neighbor.pending.size();
+    pending_stats_.bytes_pending -= neighbor.pending_bytes;
+  } );
+}
+
+static uint64_t datagram_size( const InternetDatagram& dgram )
+{
+  return dgram.header.hlen * 4 + dgram.payload.size();
+}
+
+void NetworkInterface::enqueue( ARPCache::Neighbor& neighbor, const InternetDatagram& dgram )
+{
+  const PendingLimits& limits = pending_limits_;
+  const uint64_t size = datagram_size( dgram );
+  const auto over_limits = [&] {
+    return neighbor.pending.size() + 1 > limits.max_packets_per_neighbor
+           or neighbor.pending_bytes + size > limits.max_bytes_per_neighbor
+           or pending_stats_.packets_pending + 1 > limits.max_packets
+           or pending_stats_.bytes_pending + size > limits.max_bytes;
+  };
+
+  // 即使清空该邻居的队列也放不下时，直接丢弃新数据报，不为它腾出空间
+  const bool fits_alone = 1 <= limits.max_packets_per_neighbor and size <= limits.max_bytes_per_neighbor
+                          and pending_stats_.packets_pending - neighbor.pending.size() + 1 <= limits.max_packets
+                          and pending_stats_.bytes_pending - neighbor.pending_bytes + size <= limits.max_bytes;
+  if ( not fits_alone ) {
+    ++pending_stats_.dropped_overflow;
+    return;
+  }
+
+  // 超出限制时，按策略丢弃同一邻居队首的旧数据报或丢弃新数据报
+  while ( over_limits() ) {
+    if ( limits.policy == DropPolicy::DropOldest and not neighbor.pending.empty() ) {
+      drop_oldest( neighbor );
+    } else {
+      ++pending_stats_.dropped_overflow;
+      return;
+    }
+  }
+
+  neighbor.pending.push_back( dgram );
+  neighbor.pending_bytes += size;
+  ++pending_stats_.queued;
+  ++pending_stats_.packets_pending;
+  pending_stats_.bytes_pending += size;
+}
+
+void NetworkInterface::drop_oldest( ARPCache::Neighbor& neighbor )
+{
+  const uint64_t size = datagram_size( neighbor.pending.front() );
+  neighbor.pending.pop_front();
+  neighbor.pending_bytes -= size;
+  ++pending_stats_.dropped_overflow;
+  --pending_stats_.packets_pending;
+  pending_stats_.bytes_pending -= size;
+}
+
+void NetworkInterface::learn( const uint32_t ip_address, const EthernetAddress& ethernet_address )
+{
+  ARPCache::Neighbor* neighbor = arp_cache_.find( ip_address );
+  if ( neighbor == nullptr ) {
+    neighbor = &arp_cache_.insert( ip_address );
+  } else if ( not neighbor->ethernet_address.has_value() ) {
+    // 记录从发出请求到得到应答的时间
+    const uint64_t latency = arp_cache_.now() - neighbor->requested_at;
+    const size_t bucket = min( static_cast<size_t>( bit_width( latency ) ), PendingStats::LATENCY_BUCKETS - 1 );
+    ++pending_stats_.resolve_latency_ms[bucket];
+  }
+  neighbor->ethernet_address = ethernet_address;
+  arp_cache_.expire_in( *neighbor, ARP_ENTRY_TTL_MS );
+
+  // 等待该地址的数据报一次性成批发送
+  if ( neighbor->pending.empty() ) {
+    return;
+  }
+  vector<EthernetFrame> frames;
+  frames.reserve( neighbor->pending.size() );
+  for ( const auto& dgram : neighbor->pending ) {
+    frames.push_back( make_ipv4_frame( dgram, ethernet_address ) );
+  }
+  pending_stats_.sent += frames.size();
+  pending_stats_.packets_pending -= frames.size();
+  pending_stats_.bytes_pending -= neighbor->pending_bytes;
+  neighbor->pending.clear();
+  neighbor->pending_bytes = 0;
+
+  transmit_batch( frames );
+}
+
+void NetworkInterface::send_arp( const uint16_t opcode,
+                                 const EthernetAddress& dst,
+                                 const uint32_t target_ip_address ) const
+{
+  ARPMessage arp;
+  arp.opcode = opcode;
+  arp.sender_ethernet_address = ethernet_address_;
+  arp.sender_ip_address = ip_address_.ipv4_numeric();
+  // 请求中目标以太网地址未知，填 0
+  arp.target_ethernet_address = opcode == ARPMessage::OPCODE_REQUEST ? EthernetAddress {} : dst;
+  arp.target_ip_address = target_ip_address;
+
+  transmit( { { dst, ethernet_address_, EthernetHeader::TYPE_ARP }, serialize( arp ) } );
+}
+
+EthernetFrame NetworkInterface::make_ipv4_frame( const InternetDatagram& dgram, const EthernetAddress& dst ) const
+{
+  return { { dst, ethernet_address_, EthernetHeader::TYPE_IPv4 }, serialize( dgram ) };
 }
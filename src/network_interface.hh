@@ -1,8 +1,11 @@
 #pragma once
 
+#include <array>
 #include <queue>
+#include <span>
 
 #include "address.hh"
+#include "arp_cache.hh"
 #include "ethernet_frame.hh"
 #include "ipv4_datagram.hh"
 
@@ -35,9 +38,55 @@ public:
   {
   public:
     virtual void transmit( const NetworkInterface& sender, const EthernetFrame& frame ) = 0;
+
+    // Send a burst of frames, in order. Ports that can send several frames at once (e.g. with one system
+    // call) should override this; by default each frame goes through transmit().
+    virtual void transmit_batch( const NetworkInterface& sender, std::span<const EthernetFrame> frames )
+    {
+      for ( const auto& frame : frames ) {
+        transmit( sender, frame );
+      }
+    }
+
     virtual ~OutputPort() = default;
   };
 
+  // What to do with a datagram that would take a pending queue over its limits
+  enum class DropPolicy
+  {
+    DropNewest, // drop the arriving datagram
+    DropOldest, // drop datagrams from the front of the same neighbor's queue to make room
+  };
+
+  // Limits on the datagrams held while waiting for ARP replies
+  struct PendingLimits
+  {
+    size_t max_packets_per_neighbor;
+    size_t max_bytes_per_neighbor;
+    size_t max_packets; // across all neighbors
+    size_t max_bytes;   // across all neighbors
+    DropPolicy policy;
+  };
+  static constexpr PendingLimits DEFAULT_PENDING_LIMITS {
+    64, 64 * 1024, 4096, 4 * 1024 * 1024, DropPolicy::DropNewest };
+
+  // Counters for the datagrams held while waiting for ARP replies
+  struct PendingStats
+  {
+    static constexpr size_t LATENCY_BUCKETS = 16;
+
+    uint64_t queued;             // datagrams that were held waiting for a next hop to be resolved
+    uint64_t sent;               // ... and were sent once it was
+    uint64_t dropped_overflow;   // datagrams dropped because a limit was reached
+    uint64_t dropped_unresolved; // datagrams dropped because the next hop never answered
+    uint64_t packets_pending;    // datagrams held right now
+    uint64_t bytes_pending;      // their total size
+
+    // Time from ARP request to reply: bucket 0 counts replies within the same millisecond, bucket i counts
+    // replies after [2^(i-1), 2^i) ms, and the last bucket also counts anything slower
+    std::array<uint64_t, LATENCY_BUCKETS> resolve_latency_ms;
+  };
+
   // Construct a network interface with given Ethernet (network-access-layer) and IP (internet-layer)
   // addresses
   NetworkInterface( std::string_view name,
@@ -50,6 +99,9 @@ public:
   // hop. Sending is accomplished by calling `transmit()` (a member variable) on the frame.
   void send_datagram( const InternetDatagram& dgram, const Address& next_hop );
 
+  // Sends several datagrams to the same next hop, in order (e.g. a batch forwarded by a router)
+  void send_datagrams( std::span<const InternetDatagram> dgrams, const Address& next_hop );
+
   // Receives an Ethernet frame and responds appropriately.
   // If type is IPv4, pushes the datagram to the datagrams_in queue.
   // If type is ARP request, learn a mapping from the "sender" fields, and send an ARP reply.
@@ -59,7 +111,11 @@ public:
   // Called periodically when time elapses
   void tick( size_t ms_since_last_tick );
 
+  // Bound the datagrams held while waiting for ARP replies
+  void set_pending_limits( const PendingLimits& limits ) { pending_limits_ = limits; }
+
   // Accessors
+  const PendingStats& pending_stats() const { return pending_stats_; }
   const std::string& name() const { return name_; }
   const OutputPort& output() const { return *port_; }
   OutputPort& output() { return *port_; }
@@ -72,6 +128,7 @@ private:
   // The physical output port (+ a helper function `transmit` that uses it to send an Ethernet frame)
   std::shared_ptr<OutputPort> port_;
   void transmit( const EthernetFrame& frame ) const { port_->transmit( *this, frame ); }
+  void transmit_batch( std::span<const EthernetFrame> frames ) const { port_->transmit_batch( *this, frames ); }
 
   // Ethernet (known as hardware, network-access-layer, or link-layer) address of the interface
   EthernetAddress ethernet_address_;
@@ -81,4 +138,21 @@ private:
 
   // Datagrams that have been received
   std::queue<InternetDatagram> datagrams_received_ {};
+
+  // How long a learned mapping is remembered, and how long to wait before repeating an ARP request
+  static constexpr uint64_t ARP_ENTRY_TTL_MS = 30000;
+  static constexpr uint64_t ARP_REQUEST_INTERVAL_MS = 5000;
+
+  // Known and pending neighbors
+  ARPCache arp_cache_ {};
+
+  PendingLimits pending_limits_ { DEFAULT_PENDING_LIMITS };
+  PendingStats pending_stats_ {};
+
+  void enqueue( ARPCache::Neighbor& neighbor, const InternetDatagram& dgram );
+  void drop_oldest( ARPCache::Neighbor& neighbor );
+
+  void send_arp( uint16_t opcode, const EthernetAddress& dst, uint32_t target_ip_address ) const;
+  EthernetFrame make_ipv4_frame( const InternetDatagram& dgram, const EthernetAddress& dst ) const;
+  void learn( uint32_t ip_address, const EthernetAddress& ethernet_address );
 };
@@ -1,46 +1,103 @@
 #include "reassembler.hh"
 #include <algorithm>
 #include <cstdint>
-#include <numeric>
+#include <iterator>
 
 using namespace std;
 
-void Reassembler::try_merge( Chunk&& new_chunk )
+void Reassembler::store_gaps( uint64_t first_index, string&& data )
 {
-  auto it = buffer_.begin();
-  while ( it != buffer_.end() ) {
-    uint64_t start_ = it->start;
-    uint64_t end_ = it->end;
+  const uint64_t data_end = first_index + data.size();
+  uint64_t pos = first_index; // 下一个需要检查是否已缓存的位置
+
+  // 第一个起始下标大于 first_index 的块，它前面的块是唯一可能覆盖 first_index 的块
+  auto it = buffer_.upper_bound( first_index );
+  if ( it != buffer_.begin() ) {
+    const auto& [prev_start, prev_data] = *prev( it );
+    pos = max( pos, prev_start + prev_data.size() );
+  }
 
-    if ( new_chunk.end < start_ ) {
+  // 依次填补与后续各块之间的空隙
+  while ( pos < data_end ) {
+    const uint64_t gap_end = ( it == buffer_.end() ) ? data_end : min( data_end, it->first );
+    if ( gap_end > pos ) {
+      const bool whole = ( pos == first_index && gap_end == data_end );
+      buffer_.emplace_hint( it, pos, whole ? std::move( data ) : data.substr( pos - first_index, gap_end - pos ) );
+      bytes_pending_ += gap_end - pos;
+    }
+
+    if ( it == buffer_.end() )
       break;
-    } else if ( end_ >= new_chunk.start ) {
-      // 合并重叠块
-      if ( new_chunk.start > start_ ) {
-        new_chunk.data = it->data.substr( 0, new_chunk.start - start_ ) + new_chunk.data;
-        new_chunk.start = it->start;
-      }
-
-      if ( end_ > new_chunk.end ) {
-        new_chunk.data += it->data.substr( new_chunk.end - start_ );
-        new_chunk.end = end_;
-      }
-      it = buffer_.erase( it );
-    } else {
-      ++it;
+
+    pos = max( pos, it->first + it->second.size() );
+    ++it;
+  }
+}
+
+void Reassembler::flush()
+{
+  auto& writer_ = output_.writer();
+  auto it = buffer_.begin();
+  while ( it != buffer_.end() && it->first == writer().bytes_pushed() ) {
+    bytes_pending_ -= it->second.size();
+    writer_.push( std::move( it->second ) );
+    it = buffer_.erase( it );
+  }
+}
+
+void Reassembler::store_in_place( uint64_t first_index, string_view data )
+{
+  uint64_t start = first_index;
+  uint64_t end = first_index + data.size();
+
+  // 空闲空间的第 0 个字节对应下标 bytes_pushed()，而且在提交之前不会移动
+  uint64_t offset = first_index - writer().bytes_pushed();
+  for ( const auto span : output_.writer().reserve( offset + data.size() ) ) {
+    if ( offset >= span.size() ) {
+      offset -= span.size();
+      continue;
     }
+    const auto chunk = data.substr( 0, span.size() - offset );
+    copy( chunk.begin(), chunk.end(), span.begin() + static_cast<ptrdiff_t>( offset ) );
+    data.remove_prefix( chunk.size() );
+    offset = 0;
+  }
+
+  // 快速路径：按序到达且不与已记录的区间相邻，直接提交
+  if ( start == writer().bytes_pushed() && ( ranges_.empty() || ranges_.begin()->first > end ) ) {
+    output_.writer().commit( end - start );
+    return;
+  }
+
+  // 记录区间，并与重叠或相邻的区间合并（被合并区间的字节已计入 bytes_pending_）
+  uint64_t merged = 0;
+  auto it = ranges_.upper_bound( start );
+  if ( it != ranges_.begin() && prev( it )->second >= start ) {
+    --it;
+    start = it->first;
+  }
+  while ( it != ranges_.end() && it->first <= end ) {
+    end = max( end, it->second );
+    merged += it->second - it->first;
+    it = ranges_.erase( it );
   }
+  ranges_.emplace_hint( it, start, end );
+  bytes_pending_ += end - start - merged;
+}
 
-  // 插入到正确位置（保持有序）
-  auto pos = lower_bound(
-    buffer_.begin(), buffer_.end(), new_chunk.start, []( const Chunk& c, uint64_t s ) { return c.start < s; } );
-  buffer_.insert( pos, move( new_chunk ) );
+void Reassembler::flush_in_place()
+{
+  auto it = ranges_.begin();
+  if ( it != ranges_.end() && it->first == writer().bytes_pushed() ) {
+    bytes_pending_ -= it->second - it->first;
+    output_.writer().commit( it->second - it->first );
+    ranges_.erase( it );
+  }
 }
 
 void Reassembler::insert( uint64_t first_index, string data, bool is_last_substring )
 {
   auto& constwriter_ = writer();
-  auto& writer_ = output_.writer();
   uint64_t curr_index = constwriter_.bytes_pushed();
   uint64_t capacity = constwriter_.available_capacity();
   uint64_t data_end = first_index + data.size();
@@ -65,46 +122,41 @@ void Reassembler::insert( uint64_t first_index, string data, bool is_last_substr
     return;
   }
 
-  auto length = end - start;
-  auto offset = start - first_index;
-
-  data = data.substr( offset, length );
-  first_index = start;
-
-  try_merge( Chunk( first_index, std::move( data ) ) );
+  if ( storage_ == Storage::InPlace ) {
+    store_in_place( start, string_view( data ).substr( start - first_index, end - start ) );
+    flush_in_place();
+    close_writer();
+    return;
+  }
 
-  // 处理输出
-  for ( auto it = buffer_.begin(); it != buffer_.end(); ) {
-    auto index_ = it->start;
-    auto data_ = it->data;
-    capacity = constwriter_.available_capacity();
-    curr_index = constwriter_.bytes_pushed();
-    auto size_ = data_.size();
-
-    if ( index_ > curr_index || capacity == 0 )
-      break;
+  if ( start != first_index || end != data_end ) {
+    data = data.substr( start - first_index, end - start );
+  }
 
-    if ( curr_index >= index_ && curr_index <= index_ + data_.size() ) {
-      string& chunk = it->data;
-      const uint64_t chunk_offset = curr_index - index_;
-      const uint64_t write_size = min( size_ - chunk_offset, capacity );
-      writer_.push( chunk.substr( chunk_offset, write_size ) );
-      it = buffer_.erase( it );
-    } else
-      ++it;
+  // 快速路径：按序到达且不与缓存的块重叠，直接写入
+  if ( start == curr_index && ( buffer_.empty() || buffer_.begin()->first >= end ) ) {
+    output_.writer().push( std::move( data ) );
+  } else {
+    store_gaps( start, std::move( data ) );
   }
 
+  // 处理输出
+  flush();
   close_writer();
 }
 
 uint64_t Reassembler::bytes_pending() const
 {
-  return accumulate(
-    buffer_.begin(), buffer_.end(), 0ull, []( uint64_t sum, const Chunk& c ) { return sum + c.data.size(); } );
+  return bytes_pending_;
+}
+
+Reassembler::Stats Reassembler::stats() const
+{
+  return { bytes_pending_, storage_ == Storage::InPlace ? ranges_.size() : buffer_.size() };
 }
 
 void Reassembler::close_writer()
 {
-  if ( is_last_ && buffer_.empty() )
+  if ( is_last_ && buffer_.empty() && ranges_.empty() )
     output_.writer().close();
-}
\ No newline at end of file
+}
@@ -2,13 +2,24 @@
 
 #include "byte_stream.hh"
 #include <cstdint>
-#include <deque>
+#include <map>
 
 class Reassembler
 {
 public:
+  // Where pending (not yet writable) bytes are kept
+  enum class Storage
+  {
+    Chunks,  // as separate strings in an ordered map
+    InPlace, // directly in the output ByteStream's free space, at the position they will eventually occupy;
+             // only the ranges are tracked, and flushing just commits them (no per-chunk allocations, and
+             // memory use is bounded by the stream's capacity)
+  };
+
   // Construct Reassembler to write into given ByteStream.
-  explicit Reassembler( ByteStream&& output ) : output_( std::move( output ) ), buffer_ {}, is_last_ { false } {}
+  explicit Reassembler( ByteStream&& output, Storage storage = Storage::Chunks )
+    : output_( std::move( output ) ), storage_( storage ), buffer_ {}, ranges_ {}, is_last_ { false }
+  {}
 
   /*
    * Insert a new substring to be reassembled into a ByteStream.
@@ -35,6 +46,14 @@ public:
   // How many bytes are stored in the Reassembler itself?
   uint64_t bytes_pending() const;
 
+  // Cheap snapshot of the Reassembler's bookkeeping (maintained incrementally, O(1) to read)
+  struct Stats
+  {
+    uint64_t bytes_pending;  // bytes stored but not yet written
+    uint64_t chunks_pending; // disjoint chunks (or ranges, for in-place storage) holding them
+  };
+  Stats stats() const;
+
   // Access output stream reader
   Reader& reader() { return output_.reader(); }
   const Reader& reader() const { return output_.reader(); }
@@ -45,21 +64,31 @@ public:
 private:
   ByteStream output_; // the Reassembler writes to this ByteStream
 
-  struct Chunk
-  {
-    uint64_t start;
-    std::string data;
-    uint64_t end;
+  Storage storage_;
 
-    Chunk( uint64_t start_, std::string data_ ) : start( start_ ), data( data_ ), end( start_ + data_.size() ) {};
-  };
+  // Chunks 模式：待写入的数据块，起始下标 -> 数据。区间按起始下标有序且互不重叠，
+  // 因此插入只需 O(log n) 定位，再加上与新数据重叠的块的个数
+  std::map<uint64_t, std::string> buffer_;
+
+  // InPlace 模式：已写入 output_ 空闲空间但尚未提交的区间，起始下标 -> 结束下标（有序、互不重叠且互不相邻）
+  std::map<uint64_t, uint64_t> ranges_;
 
-  std::deque<Chunk> buffer_;
   bool is_last_;
 
-  // 合并有重叠的区间
-  void try_merge( Chunk&& new_chunk );
+  uint64_t bytes_pending_ {}; // 缓存的字节数，随插入和写出增量维护
+
+  // 只保存新数据中尚未被缓存覆盖的部分（已缓存的字节不会被重复复制）
+  void store_gaps( uint64_t first_index, std::string&& data );
+
+  // 写入从 bytes_pushed() 开始连续的缓存块
+  void flush();
+
+  // InPlace 模式：把数据写到 output_ 空闲空间中对应的位置，并记录区间
+  void store_in_place( uint64_t first_index, std::string_view data );
+
+  // InPlace 模式：提交从 bytes_pushed() 开始的区间
+  void flush_in_place();
 
   // 关闭写
   void close_writer();
-};
\ No newline at end of file
+};
@@ -0,0 +1,62 @@
+#include "route_cache.hh"
+
+#include <algorithm>
+#include <bit>
+#include <stdexcept>
+
+using namespace std;
+
+RouteCache::RouteCache( const size_t num_sets )
+  : sets_( num_sets ), shift_( static_cast<uint8_t>( 32 - countr_zero( num_sets ) ) )
+{
+  if ( not has_single_bit( num_sets ) or num_sets > ( uint64_t { 1 } << 32 ) ) {
+    throw runtime_error( "RouteCache: number of sets must be a power of two" );
+  }
+}
+
+RouteCache::Set& RouteCache::set_for( const uint32_t address )
+{
+  // 乘法散列，避免同一子网的地址落到同一组
+  const uint64_t hash = static_cast<uint32_t>( address * 0x9e3779b1U );
+  return sets_[hash >> shift_];
+}
+
+optional<const RouteTable::Route*> RouteCache::find( const uint32_t address )
+{
+  Set& set = set_for( address );
+  for ( size_t i = 0; i < WAYS; ++i ) {
+    if ( set.ways[i].generation == generation_ and set.ways[i].address == address ) {
+      // 命中的表项移到最前（LRU 顺序）
+      rotate( set.ways.begin(), set.ways.begin() + i, set.ways.begin() + i + 1 );
+      ++hits_;
+      return set.ways[0].route;
+    }
+  }
+  ++misses_;
+  return {};
+}
+
+void RouteCache::insert( const uint32_t address, const RouteTable::Route* route )
+{
+  Set& set = set_for( address );
+  for ( auto& entry : set.ways ) {
+    if ( entry.generation == generation_ and entry.address == address ) {
+      entry.route = route;
+      return;
+    }
+  }
+
+  // 淘汰最后一个（最久未使用的）表项
+  rotate( set.ways.begin(), set.ways.begin() + WAYS - 1, set.ways.end() );
+  set.ways[0] = { address, generation_, route };
+}
+
+void RouteCache::clear()
+{
+  ++generation_;
+  // 代数回绕时才需要真正清空
+  if ( generation_ == 0 ) {
+    fill( sets_.begin(), sets_.end(), Set {} );
+    generation_ = 1;
+  }
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+#include "route_table.hh"
+
+// A small set-associative cache of recent route lookups, keyed on the exact destination address.
+//
+// Each set holds four entries in one cache line, kept in most-recently-used order, so a lookup for a
+// destination that was seen recently touches one line instead of the (much larger) forwarding table.
+// Negative results (no route) are cached too. Any change to the forwarding table must be followed by
+// clear(), which is O(1): entries carry the generation they were filled in, and clear() starts a new one.
+class RouteCache
+{
+public:
+  static constexpr size_t WAYS = 4;
+  static constexpr size_t DEFAULT_SETS = 256;
+
+  // `num_sets` must be a power of two
+  explicit RouteCache( size_t num_sets = DEFAULT_SETS );
+
+  // The cached route for `address` (which may be nullptr if it has no route), or empty on a miss
+  std::optional<const RouteTable::Route*> find( uint32_t address );
+
+  // Remember the route for `address`, evicting the least recently used entry of its set
+  void insert( uint32_t address, const RouteTable::Route* route );
+
+  // Forget every entry
+  void clear();
+
+  struct Stats
+  {
+    uint64_t hits;
+    uint64_t misses;
+  };
+  Stats stats() const { return { hits_, misses_ }; }
+
+  size_t capacity() const { return sets_.size() * WAYS; }
+
+private:
+  struct Entry
+  {
+    uint32_t address;
+    uint32_t generation; // valid only if equal to generation_
+    const RouteTable::Route* route;
+  };
+
+  struct alignas( 64 ) Set
+  {
+    std::array<Entry, WAYS> ways;
+  };
+
+  std::vector<Set> sets_;
+  uint8_t shift_; // the set index is the top bits of a 32-bit hash of the address
+  uint32_t generation_ { 1 };
+  uint64_t hits_ {};
+  uint64_t misses_ {};
+
+  Set& set_for( uint32_t address );
+};
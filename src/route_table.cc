@@ -0,0 +1,85 @@
+#include "route_table.hh"
+
+#include <stdexcept>
+#include <string>
+
+using namespace std;
+
+void RouteTable::add( uint32_t prefix,
+                      const uint8_t prefix_length,
+                      optional<Address> next_hop,
+                      const size_t interface_num )
+{
+  if ( prefix_length > 32 ) {
+    throw runtime_error( "RouteTable: invalid prefix length " + to_string( prefix_length ) );
+  }
+  if ( routes_.size() + 1 >= GROUP ) {
+    throw runtime_error( "RouteTable: too many routes" );
+  }
+
+  // 去掉前缀长度之外的主机位
+  prefix &= prefix_length ? ~uint32_t { 0 } << ( 32 - prefix_length ) : 0;
+
+  routes_.push_back( { prefix, prefix_length, move( next_hop ), interface_num } );
+  const uint32_t entry = routes_.size();
+
+  if ( tbl24_.empty() ) {
+    tbl24_.assign( size_t { 1 } << 24, 0 );
+  }
+
+  if ( prefix_length <= 24 ) {
+    // 覆盖 2^(24-len) 个 /24，已被更长前缀占据的位置保持不变
+    const size_t first = prefix >> 8;
+    const size_t count = size_t { 1 } << ( 24 - prefix_length );
+    for ( size_t i = first; i < first + count; ++i ) {
+      if ( tbl24_[i] & GROUP ) {
+        const size_t group = tbl24_[i] & ~GROUP;
+        for ( size_t j = 0; j < 256; ++j ) {
+          overwrite_if_not_longer( tbl8_[group << 8 | j], entry, prefix_length );
+        }
+      } else {
+        overwrite_if_not_longer( tbl24_[i], entry, prefix_length );
+      }
+    }
+    return;
+  }
+
+  // 长于 /24 的前缀：该 /24 需要一个二级表，新建时继承原来覆盖它的路由
+  uint32_t& slot = tbl24_[prefix >> 8];
+  if ( not( slot & GROUP ) ) {
+    const size_t group = tbl8_.size() >> 8;
+    tbl8_.resize( tbl8_.size() + 256, slot );
+    slot = GROUP | group;
+  }
+
+  const size_t group = slot & ~GROUP;
+  const size_t first = prefix & 0xff;
+  const size_t count = size_t { 1 } << ( 32 - prefix_length );
+  for ( size_t j = first; j < first + count; ++j ) {
+    overwrite_if_not_longer( tbl8_[group << 8 | j], entry, prefix_length );
+  }
+}
+
+void RouteTable::lookup( span<const uint32_t> addresses, span<const Route*> out ) const
+{
+  if ( out.size() < addresses.size() ) {
+    throw runtime_error( "RouteTable::lookup: output is smaller than input" );
+  }
+
+  // 先预取整批的一级表项，再逐个查找
+  if ( not tbl24_.empty() ) {
+    for ( const uint32_t address : addresses ) {
+      __builtin_prefetch( &tbl24_[address >> 8] );
+    }
+  }
+  for ( size_t i = 0; i < addresses.size(); ++i ) {
+    out[i] = lookup( addresses[i] );
+  }
+}
+
+void RouteTable::overwrite_if_not_longer( uint32_t& entry, const uint32_t new_entry, const uint8_t prefix_length ) const
+{
+  if ( entry == 0 or routes_[entry - 1].prefix_length <= prefix_length ) {
+    entry = new_entry;
+  }
+}
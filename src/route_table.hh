@@ -0,0 +1,64 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <vector>
+
+#include "address.hh"
+
+// A longest-prefix-match forwarding table for IPv4, organized as DIR-24-8
+// (Gupta, Lin & McKeown, "Routing Lookups in Hardware at Memory Access Speeds", 1998).
+//
+// The first level has one entry for every /24. An entry names the longest route covering that whole /24,
+// or, if some route is longer than /24, one of the 256-entry second-level groups that resolves the last
+// octet. A lookup is therefore one or two array reads, independent of the number of routes, at the cost
+// of a 64 MiB first level (allocated when the first route is added) and slower insertion of short prefixes.
+class RouteTable
+{
+public:
+  struct Route
+  {
+    uint32_t prefix;
+    uint8_t prefix_length;
+    std::optional<Address> next_hop; // empty if the network is directly attached
+    size_t interface_num;
+  };
+
+  // Add a route. Bits of `prefix` beyond `prefix_length` are ignored. Adding a prefix that is
+  // already in the table replaces the earlier route.
+  void add( uint32_t prefix, uint8_t prefix_length, std::optional<Address> next_hop, size_t interface_num );
+
+  // The longest-prefix match for `address`, or nullptr if no route covers it.
+  // The pointer stays valid until the next call to add().
+  const Route* lookup( uint32_t address ) const
+  {
+    if ( tbl24_.empty() ) {
+      return nullptr;
+    }
+    uint32_t entry = tbl24_[address >> 8];
+    if ( entry & GROUP ) {
+      entry = tbl8_[( entry & ~GROUP ) << 8 | ( address & 0xff )];
+    }
+    return entry ? &routes_[entry - 1] : nullptr;
+  }
+
+  // Look up several addresses at once, writing each one's match into the corresponding element of `out`.
+  // The first-level entries of the whole batch are prefetched before any of them is read, so that their
+  // cache misses overlap instead of being paid one after another.
+  void lookup( std::span<const uint32_t> addresses, std::span<const Route*> out ) const;
+
+  // Number of routes added so far
+  size_t size() const { return routes_.size(); }
+
+private:
+  // An entry is either 0 (no route), 1 + an index into routes_, or GROUP | the index of a second-level group
+  static constexpr uint32_t GROUP = uint32_t { 1 } << 31;
+
+  std::vector<Route> routes_ {};
+  std::vector<uint32_t> tbl24_ {};
+  std::vector<uint32_t> tbl8_ {};
+
+  void overwrite_if_not_longer( uint32_t& entry, uint32_t new_entry, uint8_t prefix_length ) const;
+};
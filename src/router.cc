@@ -1,7 +1,8 @@
 #include "router.hh"
 
-#include <iostream>
-#include <limits>
+#include <algorithm>
+#include <stdexcept>
+#include <string>
 
 using namespace std;
 
@@ -16,15 +17,87 @@ void Router::add_route( const uint32_t route_prefix,
                         const optional<Address> next_hop,
                         const size_t interface_num )
 {
-  cerr << "DEBUG: adding route " << Address::from_ipv4_numeric( route_prefix ).ip() << "/"
-       << static_cast<int>( prefix_length ) << " => " << ( next_hop.has_value() ? next_hop->ip() : "(direct)" )
-       << " on interface " << interface_num << "\n";
-
-  // Your code here.
+  if ( interface_num >= _interfaces.size() ) {
+    throw runtime_error( "add_route: no interface " + to_string( interface_num ) );
+  }
+  _route_table.add( route_prefix, prefix_length, next_hop, interface_num );
+  _route_cache.clear(); // 缓存的查找结果可能已失效
 }
 
 // Go through all the interfaces, and route every incoming datagram to its proper outgoing interface.
-void Router::route()
+void Router::route( const size_t batch_size )
+{
+  if ( batch_size == 0 ) {
+    throw runtime_error( "route: batch size must be positive" );
+  }
+
+  // 轮流从每个接口取出一批，直到所有接口的队列都为空
+  bool more = true;
+  while ( more ) {
+    more = false;
+    for ( const auto& in : _interfaces ) {
+      auto& queue = in->datagrams_received();
+      _batch.clear();
+      while ( not queue.empty() and _batch.size() < batch_size ) {
+        _batch.push_back( move( queue.front() ) );
+        queue.pop();
+      }
+      more |= not queue.empty();
+      forward_batch();
+    }
+  }
+}
+
+void Router::forward_batch()
 {
-  // Your code here.
+  if ( _batch.empty() ) {
+    return;
+  }
+
+  // 先查路由缓存，未命中的再整批查表
+  _batch_routes.resize( _batch.size() );
+  _batch_misses.clear();
+  _batch_destinations.clear();
+  for ( size_t i = 0; i < _batch.size(); ++i ) {
+    const auto cached = _route_cache.find( _batch[i].header.dst );
+    if ( cached ) {
+      _batch_routes[i] = *cached;
+    } else {
+      _batch_misses.push_back( i );
+      _batch_destinations.push_back( _batch[i].header.dst );
+    }
+  }
+
+  _miss_routes.resize( _batch_misses.size() );
+  _route_table.lookup( _batch_destinations, _miss_routes );
+  for ( size_t k = 0; k < _batch_misses.size(); ++k ) {
+    _batch_routes[_batch_misses[k]] = _miss_routes[k];
+    _route_cache.insert( _batch_destinations[k], _miss_routes[k] );
+  }
+
+  // TTL 耗尽或没有匹配的路由则丢弃，其余按 (出接口, 下一跳) 分组，组内保持原有顺序
+  _batch_order.clear();
+  for ( size_t i = 0; i < _batch.size(); ++i ) {
+    const RouteTable::Route* route = _batch_routes[i];
+    if ( _batch[i].header.ttl <= 1 or route == nullptr ) {
+      continue;
+    }
+    const uint32_t next_hop = route->next_hop ? route->next_hop->ipv4_numeric() : _batch[i].header.dst;
+    _batch_order.emplace_back( static_cast<uint64_t>( route->interface_num ) << 32 | next_hop, i );
+  }
+  sort( _batch_order.begin(), _batch_order.end() );
+
+  for ( auto group_begin = _batch_order.begin(); group_begin != _batch_order.end(); ) {
+    const uint64_t key = group_begin->first;
+    _group.clear();
+    auto it = group_begin;
+    for ( ; it != _batch_order.end() and it->first == key; ++it ) {
+      InternetDatagram& dgram = _batch[it->second];
+      dgram.header.decrement_ttl(); // 增量更新校验和
+      _group.push_back( move( dgram ) );
+    }
+    group_begin = it;
+
+    _interfaces[key >> 32]->send_datagrams( _group, Address::from_ipv4_numeric( static_cast<uint32_t>( key ) ) );
+  }
 }
@@ -5,12 +5,19 @@
 
 #include "exception.hh"
 #include "network_interface.hh"
+#include "route_cache.hh"
+#include "route_table.hh"
 
 // \brief A router that has multiple network interfaces and
 // performs longest-prefix-match routing between them.
 class Router
 {
 public:
+  Router() = default;
+
+  // Use a route cache of `route_cache_sets` sets (a power of two) in front of the forwarding table
+  explicit Router( size_t route_cache_sets ) : _route_cache( route_cache_sets ) {}
+
   // Add an interface to the router
   // \param[in] interface an already-constructed network interface
   // \returns The index of the interface after it has been added to the router
@@ -30,9 +37,37 @@ public:
                   size_t interface_num );
 
   // Route packets between the interfaces
-  void route();
+  void route() { route( DEFAULT_BATCH_SIZE ); }
+
+  // Route packets between the interfaces, taking up to `batch_size` datagrams from each interface at a time.
+  // Each batch is looked up in one pass and handed to the output interfaces grouped by next hop.
+  void route( size_t batch_size );
+
+  static constexpr size_t DEFAULT_BATCH_SIZE = 64;
+
+  // The forwarding table
+  const RouteTable& route_table() const { return _route_table; }
+
+  // Hits and misses of the route cache, for sizing it
+  RouteCache::Stats route_cache_stats() const { return _route_cache.stats(); }
 
 private:
   // The router's collection of network interfaces
   std::vector<std::shared_ptr<NetworkInterface>> _interfaces {};
+
+  // Longest-prefix-match table of the routes added so far
+  RouteTable _route_table {};
+
+  // Recently looked-up destinations (cleared whenever a route is added)
+  RouteCache _route_cache {};
+
+  // Look up and send the datagrams in _batch (scratch space below is reused from batch to batch)
+  void forward_batch();
+  std::vector<InternetDatagram> _batch {};
+  std::vector<uint32_t> _batch_destinations {};
+  std::vector<const RouteTable::Route*> _batch_routes {};
+  std::vector<size_t> _batch_misses {}; // indices in _batch that missed the route cache
+  std::vector<const RouteTable::Route*> _miss_routes {};
+  std::vector<std::pair<uint64_t, size_t>> _batch_order {}; // (output interface and next hop, index in _batch)
+  std::vector<InternetDatagram> _group {};
 };
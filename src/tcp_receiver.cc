@@ -34,7 +34,7 @@ void TCPReceiver::receive( TCPSenderMessage message )
   uint64_t first_index = seqno.unwrap( zero_point_, checkpoint ); // 确实插入位置
 
   // 插入数据
-  reassembler_.insert( first_index, message.payload, is_last_string );
+  reassembler_.insert( first_index, static_cast<string>( message.payload ), is_last_string );
 
   // 若没有多余数据并且 is_fin 为真，则关闭reassembler
   if ( !reassembler_.bytes_pending() && is_fin ) {
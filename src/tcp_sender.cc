@@ -3,17 +3,12 @@
 #include "tcp_sender_message.hh"
 #include "wrapping_integers.hh"
 #include <cstdint>
-#include <memory>
-#include <numeric>
 
 using namespace std;
 
 uint64_t TCPSender::sequence_numbers_in_flight() const
 {
-  return std::accumulate( outstanding_segments_time.begin(),
-                          outstanding_segments_time.end(),
-                          0ull,
-                          []( uint64_t sum, auto item ) { return sum + item.second->sequence_length(); } );
+  return sequence_numbers_in_flight_;
 }
 
 uint64_t TCPSender::consecutive_retransmissions() const
@@ -21,6 +16,11 @@ uint64_t TCPSender::consecutive_retransmissions() const
   return consecutive_retransmission_cnts_;
 }
 
+TCPSender::Stats TCPSender::stats() const
+{
+  return { sequence_numbers_in_flight_, outstanding_.size() - outstanding_head_, consecutive_retransmission_cnts_ };
+}
+
 void TCPSender::push( const TransmitFunction& transmit )
 {
   // RST 位为真
@@ -38,7 +38,7 @@ void TCPSender::push( const TransmitFunction& transmit )
   window_size_ += is_zero_window_size + ( is_syn & no_ack );
 
   // 判断当前窗口是否能装下数据
-  if ( reader().bytes_buffered() + data_.size() + is_syn + !is_fin <= window_size_ )
+  if ( bytes_unsent_() + is_syn + !is_fin <= window_size_ )
     can_output = true;
 
   // 要尽可能填充满 window_size_ 的大小， 通过多次分段发送
@@ -57,14 +57,14 @@ void TCPSender::push( const TransmitFunction& transmit )
     }
 
     // 取出数据
-    std::string data = get_data_( max_size );
+    const uint64_t payload_size = take_data_( max_size );
 
     // 防止重复发送 fin 帧
-    if ( is_fin && data.empty() )
+    if ( is_fin && !payload_size )
       return;
 
     // 最后一个发送段
-    if ( !reader().bytes_buffered() && data_.empty() )
+    if ( !bytes_unsent_() )
       last_output = true;
 
     // 如果当前窗口可以全部输出，当前为最后一个发送段，且is_closed()为真
@@ -72,21 +72,22 @@ void TCPSender::push( const TransmitFunction& transmit )
       is_fin = true;
 
     // 如果非 syn 和 fin 帧数据为空，直接返回
-    if ( !is_syn_ && !is_fin && data.empty() )
+    if ( !is_syn_ && !is_fin && !payload_size )
       return;
 
-    // 数据段
-    std::shared_ptr<TCPSenderMessage> sm
-      = std::make_shared<TCPSenderMessage>( isn_, is_syn_, std::move( data ), is_fin, false );
+    // 数据段（负载是 input_ 中未确认字节的最后 payload_size 个）
+    const OutstandingSegment seg { isn_, is_syn_, payload_size, is_fin };
+    const uint64_t seq_len = seg.sequence_length();
 
-    window_size_ -= sm->sequence_length(); // 更新window_size
+    window_size_ -= seq_len; // 更新window_size
 
     // 插入未应答段
-    outstanding_segments_time.insert( { no_++, sm } );
+    outstanding_.push_back( seg );
+    sequence_numbers_in_flight_ += seq_len;
 
-    isn_ = isn_ + sm->sequence_length();    // 更新 isn
-    total_isn_no_ += sm->sequence_length(); // 累计总的发射序号，作为receive的checkpoint
-    transmit( std::move( *sm ) );           // std::move 之后 *sm 是否存在
+    isn_ = isn_ + seq_len;    // 更新 isn
+    total_isn_no_ += seq_len; // 累计总的发射序号，作为receive的checkpoint
+    transmit( make_message_( seg, bytes_unacked_ - payload_size ) );
   }
 
   is_zero_window_size = false; // is_zero_window_size 只能用一次
@@ -103,6 +104,10 @@ void TCPSender::receive( const TCPReceiverMessage& msg )
   if ( msg.RST )
     input_.set_error();
 
+  // 出错后输入流不再弹出字节，不再处理确认，否则未确认字节的记录会与 input_ 中的内容不一致
+  if ( input_.has_error() )
+    return;
+
   is_zero_window_size = !msg.window_size; // 设置 is_zero_window_size
   no_ack = false;                         // 设置 no_ack
   receive_window_size_ = msg.window_size; // 更新收到窗口大小
@@ -122,16 +127,16 @@ void TCPSender::receive( const TCPReceiverMessage& msg )
 
   // 按照发送数据顺序，删除确认的数据
   bool is_new_ack = false; // 新确认帧
-  for ( auto it = outstanding_segments_time.begin(); it != outstanding_segments_time.end(); ) {
-    auto data = it->second;
-    auto data_start = data->seqno;
-    auto data_size = data->sequence_length();
-    auto data_end = data_start + data->sequence_length();
+  while ( outstanding_head_ < outstanding_.size() ) {
+    const auto& seg = outstanding_[outstanding_head_];
+    auto data_size = seg.sequence_length();
+    auto data_end = seg.seqno + data_size;
 
     // 确认数据帧
     if ( data_end <= ackno ) {
-      total_ack_no_ += data_size;                 // 更新确认数据总数
-      it = outstanding_segments_time.erase( it ); // 删除该数据段
+      total_ack_no_ += data_size;               // 更新确认数据总数
+      sequence_numbers_in_flight_ -= data_size; // 更新未确认序号总数
+      pop_outstanding_();                       // 删除该数据段
       is_new_ack = true;
     } else // 否则直接退出，避免套环
       break;
@@ -152,7 +157,7 @@ void TCPSender::receive( const TCPReceiverMessage& msg )
 void TCPSender::tick( uint64_t ms_since_last_tick, const TransmitFunction& transmit )
 {
   // 没有待确认数据，直接返回
-  if ( outstanding_segments_time.empty() )
+  if ( outstanding_head_ == outstanding_.size() )
     return;
 
   // 更新 rto_ms_
@@ -160,9 +165,8 @@ void TCPSender::tick( uint64_t ms_since_last_tick, const TransmitFunction& trans
 
   // rto_ms 为 0，定时器到时
   if ( !rto_ms_ ) {
-    auto it = outstanding_segments_time.begin(); // 当前最早发送数据段
-
-    transmit( *( it->second ) );
+    // 当前最早发送数据段，负载位于 input_ 的开头
+    transmit( make_message_( outstanding_[outstanding_head_], 0 ) );
 
     // 收到窗口大小为 0 或者
     // no_ack 为真，表明当前未确认 syn 帧
@@ -180,27 +184,46 @@ void TCPSender::tick( uint64_t ms_since_last_tick, const TransmitFunction& trans
   }
 }
 
-// 获取num大小的数据
-std::string TCPSender::get_data_( uint64_t num )
+// 从输入流中再发送至多 num 字节
+uint64_t TCPSender::take_data_( uint64_t num )
 {
-  // 没有数据
-  if ( !num || ( !reader().bytes_buffered() && data_.empty() ) )
-    return std::string {};
-
-  // 获取num大小数据
-  while ( data_.size() < num ) {
-    std::string_view t = input_.reader().peek();
-
-    if ( t.empty() )
-      break;
+  const uint64_t taken = std::min( num, bytes_unsent_() );
+  bytes_unacked_ += taken;
+  return taken;
+}
 
-    input_.reader().pop( t.size() );
-    data_ += t;
+TCPSenderMessage TCPSender::make_message_( const OutstandingSegment& seg, uint64_t payload_offset ) const
+{
+  std::string payload;
+  payload.reserve( seg.payload_size );
+
+  // 负载可能跨越环形缓冲区的回绕点
+  uint64_t need = seg.payload_size;
+  for ( std::string_view t : input_.reader().peek_all() ) {
+    const uint64_t skip = std::min( payload_offset, t.size() );
+    payload_offset -= skip;
+    t = t.substr( skip, need );
+    payload += t;
+    need -= t.size();
   }
 
-  uint64_t offset = std::min( data_.size(), num );
-  std::string str = data_.substr( 0, offset ); // 截取 num 位
-  data_ = data_.substr( offset );              // 多取出的数据
+  return { seg.seqno, seg.SYN, std::move( payload ), seg.FIN, false };
+}
 
-  return str;
-}
\ No newline at end of file
+void TCPSender::pop_outstanding_()
+{
+  // 确认后才从输入流中释放负载
+  const uint64_t payload_size = outstanding_[outstanding_head_].payload_size;
+  input_.reader().pop( payload_size );
+  bytes_unacked_ -= payload_size;
+  ++outstanding_head_;
+
+  // 全部确认时直接清空；否则在已确认部分超过一半时整体前移，均摊 O(1) 且不释放已分配的空间
+  if ( outstanding_head_ == outstanding_.size() ) {
+    outstanding_.clear();
+    outstanding_head_ = 0;
+  } else if ( outstanding_head_ * 2 >= outstanding_.size() ) {
+    outstanding_.erase( outstanding_.begin(), outstanding_.begin() + static_cast<ptrdiff_t>( outstanding_head_ ) );
+    outstanding_head_ = 0;
+  }
+}
@@ -6,11 +6,9 @@
 
 #include <cstdint>
 #include <functional>
-#include <list>
-#include <map>
-#include <memory>
 #include <optional>
-#include <queue>
+#include <string>
+#include <vector>
 
 class TCPSender
 {
@@ -42,26 +40,57 @@ public:
   // Accessors
   uint64_t sequence_numbers_in_flight() const;  // How many sequence numbers are outstanding?
   uint64_t consecutive_retransmissions() const; // How many consecutive *re*transmissions have happened?
+
+  // Cheap snapshot of the sender's bookkeeping (maintained incrementally, O(1) to read)
+  struct Stats
+  {
+    uint64_t sequence_numbers_in_flight;
+    uint64_t segments_in_flight;
+    uint64_t consecutive_retransmissions;
+  };
+  Stats stats() const;
   Writer& writer() { return input_.writer(); }
   const Writer& writer() const { return input_.writer(); }
 
-  // Access input stream reader, but const-only (can't read from outside)
+  // Access input stream reader, but const-only (can't read from outside).
+  // Bytes stay buffered in the input stream until they are acknowledged.
   const Reader& reader() const { return input_.reader(); }
 
+  // Has the whole input stream been sent (though possibly not yet acknowledged)?
+  bool finished_sending() const { return writer().is_closed() and bytes_unsent_() == 0; }
+
 private:
   // Variables initialized in constructor
   ByteStream input_;
   Wrap32 isn_;
   uint64_t initial_RTO_ms_;
-  std::map<uint64_t, std::shared_ptr<TCPSenderMessage>> outstanding_segments_time {};
+
+  // 未确认数据段的描述（不含负载本身，负载按发送顺序连续保存在 input_ 的开头）
+  struct OutstandingSegment
+  {
+    Wrap32 seqno;
+    bool SYN;
+    uint64_t payload_size;
+    bool FIN;
+
+    uint64_t sequence_length() const { return SYN + payload_size + FIN; }
+  };
+
+  // 未确认数据段的先进先出队列：确认总是从队首移除，[outstanding_head_, size()) 为有效部分
+  std::vector<OutstandingSegment> outstanding_ {};
+  size_t outstanding_head_ {};
+
+  // 已发送未确认的负载字节数。这些字节仍保留在 input_ 的开头，收到确认后才弹出，
+  // 因此队首数据段的负载总是从 input_ 的开头开始，重传时直接从中读取
+  uint64_t bytes_unacked_ {};
+
   Wrap32 zero_point_;                           // 存储偏移量
-  std::string data_ {};                         // 存储多取出来的数据
   uint64_t consecutive_retransmission_cnts_ {}; // 连续重发数据段数
+  uint64_t sequence_numbers_in_flight_ {};      // 未确认序号总数，随发送和确认增量维护
   uint64_t window_size_ {};                     // 窗口大小
   uint64_t receive_window_size_ {};             // 收到窗口大小
   uint64_t rto_ms_ {};                          // 当前 rts 时间
   uint64_t base_rto_ms_ {};                     // rts 的倍数
-  uint64_t no_ {};                              // 发送数据段顺序
   uint64_t total_ack_no_ {};                    // 确认数据总数，作为ack_no unwrap的checkpoint
   uint64_t total_isn_no_ {};                    // 发送数据总数，作为isn_no unwrap的checkpoint
 
@@ -70,6 +99,15 @@ private:
   bool is_zero_window_size { false }; // 窗口为0标志
   bool no_ack { true };               // 还未收到应答帧
 
-  // get_data
-  std::string get_data_( uint64_t num );
+  // 输入流中尚未发送的字节数
+  uint64_t bytes_unsent_() const { return reader().bytes_buffered() - bytes_unacked_; }
+
+  // 从输入流中再发送至多 num 字节（只移动发送位置，不弹出），返回字节数
+  uint64_t take_data_( uint64_t num );
+
+  // 用描述和 input_ 中从 payload_offset 开始的负载重建数据段
+  TCPSenderMessage make_message_( const OutstandingSegment& seg, uint64_t payload_offset ) const;
+
+  // 移除队首的未确认数据段及其负载
+  void pop_outstanding_();
 };
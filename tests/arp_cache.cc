@@ -0,0 +1,91 @@
+#include "arp_cache.hh"
+#include "random.hh"
+#include "test_should_be.hh"
+
+#include <cstdint>
+#include <exception>
+#include <iostream>
+#include <map>
+
+using namespace std;
+
+int main()
+{
+  try {
+    auto rd = get_random_engine();
+
+    // find, insert and erase, compared against std::map (addresses drawn from a small range so that
+    // they collide in the index and erasure has to repair probe sequences)
+    {
+      ARPCache cache;
+      map<uint32_t, uint8_t> reference;
+      for ( size_t i = 0; i < 200000; ++i ) {
+        const uint32_t ip = 0x0a000000 | ( rd() % 512 );
+        ARPCache::Neighbor* neighbor = cache.find( ip );
+        const auto it = reference.find( ip );
+        test_should_be( neighbor != nullptr, it != reference.end() );
+
+        if ( neighbor ) {
+          test_should_be( neighbor->ip_address, ip );
+          test_should_be( neighbor->ethernet_address.value().at( 5 ), it->second );
+          if ( rd() % 2 ) {
+            cache.erase( ip );
+            reference.erase( it );
+          }
+        } else {
+          const auto tag = static_cast<uint8_t>( rd() );
+          cache.insert( ip ).ethernet_address = EthernetAddress { 2, 0, 0, 0, 0, tag };
+          reference[ip] = tag;
+        }
+        test_should_be( cache.size(), reference.size() );
+      }
+    }
+
+    // expiry, and re-arming the expiry
+    {
+      ARPCache cache;
+      cache.expire_in( cache.insert( 1 ), 5000 );
+      cache.expire_in( cache.insert( 2 ), 30000 );
+      cache.insert( 3 ); // never expires
+
+      cache.tick( 4999 );
+      test_should_be( cache.find( 1 ) != nullptr, true );
+      cache.tick( 1 );
+      test_should_be( cache.find( 1 ) == nullptr, true );
+      test_should_be( cache.size(), size_t { 2 } );
+
+      cache.tick( 20000 );
+      cache.expire_in( *cache.find( 2 ), 30000 ); // now due at 55000
+      cache.tick( 10000 );
+      test_should_be( cache.find( 2 ) != nullptr, true );
+      cache.tick( 19999 );
+      test_should_be( cache.find( 2 ) != nullptr, true );
+      cache.tick( 1 );
+      test_should_be( cache.find( 2 ) == nullptr, true );
+
+      // a neighbor that is erased and re-added does not inherit the old timer
+      cache.expire_in( cache.insert( 4 ), 100 );
+      cache.erase( 4 );
+      cache.insert( 4 );
+      cache.tick( 1000 );
+      test_should_be( cache.find( 4 ) != nullptr, true );
+      test_should_be( cache.find( 3 ) != nullptr, true );
+      test_should_be( cache.size(), size_t { 2 } );
+    }
+
+    // copies are independent
+    {
+      ARPCache cache;
+      cache.expire_in( cache.insert( 7 ), 10 );
+      ARPCache copy = cache;
+      cache.tick( 10 );
+      test_should_be( cache.find( 7 ) == nullptr, true );
+      test_should_be( copy.find( 7 ) != nullptr, true );
+    }
+  } catch ( const exception& e ) {
+    cerr << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
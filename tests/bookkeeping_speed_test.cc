@@ -0,0 +1,151 @@
+#include "arp_cache.hh"
+#include "reassembler.hh"
+#include "tcp_config.hh"
+#include "tcp_sender.hh"
+
+#include <chrono>
+#include <cstddef>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <string>
+
+using namespace std;
+using namespace std::chrono;
+
+// Per-segment bookkeeping (bytes_pending, sequence_numbers_in_flight, ARP expiry) must cost the same no
+// matter how many chunks, segments or neighbors are queued. Each test measures the cost of one segment's
+// worth of work at a shallow and a deep queue, and fails if the deep one is much slower.
+
+static constexpr size_t SHALLOW = 16;
+static constexpr size_t DEEP = 32768;
+static constexpr size_t REPS = 1000000;
+static constexpr double MAX_SLOWDOWN = 8;
+
+static string storage_name( Reassembler::Storage storage )
+{
+  return storage == Reassembler::Storage::InPlace ? "in-place" : "chunks";
+}
+
+// Nanoseconds per (duplicate insert + bytes_pending) with `depth` disjoint chunks pending
+double reassembler_ns_per_segment( const size_t depth, const Reassembler::Storage storage )
+{
+  Reassembler reassembler { ByteStream { 2 * depth + 2 }, storage };
+  for ( size_t i = 0; i < depth; ++i ) {
+    reassembler.insert( 2 * i + 1, "x", false );
+  }
+  if ( reassembler.stats().chunks_pending != depth || reassembler.bytes_pending() != depth ) {
+    throw runtime_error( "Reassembler did not keep " + to_string( depth ) + " chunks pending" );
+  }
+
+  uint64_t total = 0;
+  const auto start_time = steady_clock::now();
+  for ( size_t i = 0; i < REPS; ++i ) {
+    reassembler.insert( 1, "x", false );
+    total += reassembler.bytes_pending();
+  }
+  const auto stop_time = steady_clock::now();
+
+  if ( total != depth * REPS ) {
+    throw runtime_error( "Reassembler bytes_pending changed on duplicate insert" );
+  }
+
+  return duration_cast<duration<double, nano>>( stop_time - start_time ).count() / REPS;
+}
+
+// Nanoseconds per (duplicate ack + sequence_numbers_in_flight) with `depth` one-byte segments outstanding
+double sender_ns_per_segment( const size_t depth )
+{
+  const Wrap32 isn { 0 };
+  TCPSender sender { ByteStream { TCPConfig::DEFAULT_CAPACITY }, isn, TCPConfig::TIMEOUT_DFLT };
+  const auto transmit = []( const TCPSenderMessage& ) {};
+
+  sender.push( transmit ); // SYN
+  const TCPReceiverMessage ack { isn + 1, UINT16_MAX, false };
+  sender.receive( ack );
+  for ( size_t i = 0; i < depth; ++i ) {
+    sender.writer().push( "x" );
+    sender.push( transmit );
+  }
+  if ( sender.stats().segments_in_flight != depth || sender.sequence_numbers_in_flight() != depth ) {
+    throw runtime_error( "TCPSender did not keep " + to_string( depth ) + " segments outstanding" );
+  }
+
+  uint64_t total = 0;
+  const auto start_time = steady_clock::now();
+  for ( size_t i = 0; i < REPS; ++i ) {
+    sender.receive( ack );
+    total += sender.sequence_numbers_in_flight();
+  }
+  const auto stop_time = steady_clock::now();
+
+  if ( total != depth * REPS ) {
+    throw runtime_error( "TCPSender sequence_numbers_in_flight changed on duplicate ack" );
+  }
+
+  return duration_cast<duration<double, nano>>( stop_time - start_time ).count() / REPS;
+}
+
+// Nanoseconds per (1 ms tick + re-arming one neighbor's expiry) with `depth` neighbors in the ARP cache
+double arp_cache_ns_per_tick( const size_t depth )
+{
+  // long enough that every neighbor is refreshed before it expires
+  const uint64_t ttl = 2 * DEEP;
+  ARPCache cache;
+  for ( size_t i = 0; i < depth; ++i ) {
+    cache.expire_in( cache.insert( i ), ttl );
+  }
+
+  const auto start_time = steady_clock::now();
+  for ( size_t i = 0; i < REPS; ++i ) {
+    cache.tick( 1 );
+    cache.expire_in( *cache.find( i % depth ), ttl );
+  }
+  const auto stop_time = steady_clock::now();
+
+  if ( cache.size() != depth ) {
+    throw runtime_error( "ARPCache expired a neighbor that was still being refreshed" );
+  }
+
+  return duration_cast<duration<double, nano>>( stop_time - start_time ).count() / REPS;
+}
+
+void report( const string& name, const double shallow_ns, const double deep_ns )
+{
+  fstream debug_output;
+  debug_output.open( "/dev/tty" );
+
+  cout << name << ": " << fixed << setprecision( 1 ) << shallow_ns << " ns/segment with " << SHALLOW
+       << " queued, " << deep_ns << " ns/segment with " << DEEP << " queued.\n";
+
+  debug_output << "   " << name << " per-segment cost: " << fixed << setprecision( 1 ) << shallow_ns << " ns ("
+               << SHALLOW << " queued), " << deep_ns << " ns (" << DEEP << " queued)\n";
+
+  if ( deep_ns > MAX_SLOWDOWN * shallow_ns ) {
+    throw runtime_error( name + " per-segment cost grows with queue depth." );
+  }
+}
+
+void program_body()
+{
+  for ( const auto storage : { Reassembler::Storage::Chunks, Reassembler::Storage::InPlace } ) {
+    report( "Reassembler (" + storage_name( storage ) + ")",
+            reassembler_ns_per_segment( SHALLOW, storage ),
+            reassembler_ns_per_segment( DEEP, storage ) );
+  }
+
+  report( "TCPSender", sender_ns_per_segment( SHALLOW ), sender_ns_per_segment( DEEP ) );
+  report( "ARPCache tick", arp_cache_ns_per_tick( SHALLOW ), arp_cache_ns_per_tick( DEEP ) );
+}
+
+int main()
+{
+  try {
+    program_body();
+  } catch ( const exception& e ) {
+    cerr << "Exception: " << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,122 @@
+#include "concurrent_byte_stream.hh"
+#include "eventloop.hh"
+
+#include <cstddef>
+#include <exception>
+#include <iostream>
+#include <poll.h>
+#include <random>
+#include <stdexcept>
+#include <thread>
+
+using namespace std;
+
+static string make_data( size_t input_len, default_random_engine& rd )
+{
+  uniform_int_distribution<char> ud;
+  string ret;
+  for ( size_t i = 0; i < input_len; ++i ) {
+    ret += ud( rd );
+  }
+  return ret;
+}
+
+static void expect( bool condition, const string& msg )
+{
+  if ( not condition ) {
+    throw runtime_error( msg );
+  }
+}
+
+// Single-threaded sanity check of the Reader/Writer bookkeeping.
+void basic_test()
+{
+  ConcurrentByteStream bs { 8 };
+
+  bs.writer().push( "abcdef" );
+  expect( bs.writer().bytes_pushed() == 6, "bytes_pushed should be 6" );
+  expect( bs.writer().available_capacity() == 2, "available_capacity should be 2" );
+  expect( bs.readable_event().clear(), "push should notify the readable event" );
+  expect( not bs.readable_event().clear(), "clear should reset the readable event" );
+
+  bs.reader().pop( 5 );
+  expect( bs.writable_event().clear(), "pop should notify the writable event" );
+  bs.writer().push( "ghijklmno" );
+  expect( bs.writer().bytes_pushed() == 13, "push should be limited by available capacity" );
+
+  const auto peeked = bs.reader().peek_all();
+  expect( peeked[0] == "fgh" and peeked[1] == "ijklm", "peek_all should return both wrapped segments" );
+
+  bs.writer().close();
+  expect( bs.writer().is_closed(), "stream should be closed" );
+  expect( not bs.reader().is_finished(), "stream should not be finished before it is drained" );
+  bs.reader().pop( 8 );
+  expect( bs.reader().is_finished(), "stream should be finished" );
+  expect( bs.reader().bytes_popped() == 13, "bytes_popped should be 13" );
+}
+
+// One writer thread and one reader thread (sleeping in an EventLoop) moving random-sized chunks.
+void threaded_test( const size_t input_len,    // NOLINT(bugprone-easily-swappable-parameters)
+                    const size_t capacity,     // NOLINT(bugprone-easily-swappable-parameters)
+                    const size_t random_seed ) // NOLINT(bugprone-easily-swappable-parameters)
+{
+  default_random_engine rd { random_seed };
+  const string data = make_data( input_len, rd );
+
+  ConcurrentByteStream bs { capacity };
+
+  thread writer_thread( [&] {
+    default_random_engine writer_rd { random_seed + 1 };
+    uniform_int_distribution<size_t> chunk_size { 1, capacity * 2 };
+    size_t pushed = 0;
+    while ( pushed < data.size() ) {
+      bs.writable_event().clear();
+      if ( bs.writer().available_capacity() == 0 ) {
+        pollfd pfd { bs.writable_event().fd_num(), POLLIN, 0 };
+        ::poll( &pfd, 1, -1 );
+        continue;
+      }
+      bs.writer().push( string_view { data }.substr( pushed, chunk_size( writer_rd ) ) );
+      pushed = bs.writer().bytes_pushed();
+    }
+    bs.writer().close();
+  } );
+
+  string output;
+  output.reserve( data.size() );
+
+  EventLoop loop;
+  loop.add_rule(
+    "read from concurrent byte stream",
+    bs.readable_event(),
+    Direction::In,
+    [&] {
+      bs.readable_event().clear();
+      for ( const auto segment : bs.reader().peek_all() ) {
+        output += segment;
+      }
+      bs.reader().pop( output.size() - bs.reader().bytes_popped() );
+    },
+    [&] { return not bs.reader().is_finished(); } );
+
+  while ( loop.wait_next_event( -1 ) != EventLoop::Result::Exit ) {}
+
+  writer_thread.join();
+
+  expect( output == data, "mismatch between data written and read" );
+}
+
+int main()
+{
+  try {
+    basic_test();
+    threaded_test( 1e4, 1, 1066 );
+    threaded_test( 1e6, 4096, 1067 );
+    threaded_test( 1e6, 65536, 1068 );
+  } catch ( const exception& e ) {
+    cerr << "Exception: " << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,82 @@
+#include "byte_stream.hh"
+#include "byte_stream_test_harness.hh"
+#include "exception.hh"
+
+#include <array>
+#include <cerrno>
+#include <cstddef>
+#include <exception>
+#include <iostream>
+#include <linux/filter.h>
+#include <linux/seccomp.h>
+#include <stdexcept>
+#include <sys/prctl.h>
+#include <sys/syscall.h>
+
+using namespace std;
+
+namespace {
+
+// Make memfd_create fail with ENOSYS for the rest of the process, as in a sandbox that does not allow it
+void forbid_memfd_create()
+{
+  array<sock_filter, 4> filter { {
+    BPF_STMT( BPF_LD | BPF_W | BPF_ABS, offsetof( seccomp_data, nr ) ),
+    BPF_JUMP( BPF_JMP | BPF_JEQ | BPF_K, __NR_memfd_create, 0, 1 ),
+    BPF_STMT( BPF_RET | BPF_K, SECCOMP_RET_ERRNO | ( ENOSYS & SECCOMP_RET_DATA ) ),
+    BPF_STMT( BPF_RET | BPF_K, SECCOMP_RET_ALLOW ),
+  } };
+  sock_fprog program { static_cast<unsigned short>( filter.size() ), filter.data() };
+
+  CheckSystemCall( "prctl(PR_SET_NO_NEW_PRIVS)", prctl( PR_SET_NO_NEW_PRIVS, 1, 0, 0, 0 ) );
+  CheckSystemCall( "prctl(PR_SET_SECCOMP)", prctl( PR_SET_SECCOMP, SECCOMP_MODE_FILTER, &program ) );
+}
+
+} // namespace
+
+int main()
+{
+  try {
+    forbid_memfd_create();
+
+    bool mirror_failed = false;
+    try {
+      const MirroredBuffer mirror { MirroredBuffer::page_size() };
+    } catch ( const unix_error& ) {
+      mirror_failed = true;
+    }
+    if ( not mirror_failed ) {
+      throw runtime_error( "MirroredBuffer should fail without memfd_create" );
+    }
+
+    // a Mirrored stream still works, as an ordinary (PowerOfTwo) ring
+    {
+      ByteStreamTestHarness test { "mirrored-fallback-wraparound", 8, ByteStream::Storage::Mirrored };
+
+      test.execute( Push { "abcdef" } );
+      test.execute( Pop { 5 } );
+      test.execute( Push { "ghijk" } );
+
+      test.execute( BytesBuffered { 6 } );
+      test.execute( AvailableCapacity { 2 } );
+      test.execute( PeekAll { "fgh", "ijk" } );
+      test.execute( Peek { "fghijk" } );
+      test.execute( ReadAll { "fghijk" } );
+    }
+
+    {
+      ByteStreamTestHarness test { "mirrored-fallback-capacity", 5, ByteStream::Storage::Mirrored };
+
+      test.execute( Push { "abcdefgh" } );
+      test.execute( BytesPushed { 5 } );
+      test.execute( AvailableCapacity { 0 } );
+      test.execute( ReadAll { "abcde" } );
+      test.execute( AvailableCapacity { 5 } );
+    }
+  } catch ( const exception& e ) {
+    cerr << "Exception: " << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
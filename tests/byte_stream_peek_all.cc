@@ -0,0 +1,85 @@
+#include "byte_stream.hh"
+#include "byte_stream_test_harness.hh"
+
+#include <exception>
+#include <iostream>
+
+using namespace std;
+
+int main()
+{
+  try {
+    {
+      ByteStreamTestHarness test { "peek_all-empty", 8 };
+
+      test.execute( PeekAll { "", "" } );
+      test.execute( Push { "abc" } );
+      test.execute( Pop { 3 } );
+      test.execute( PeekAll { "", "" } );
+    }
+
+    {
+      ByteStreamTestHarness test { "peek_all-contiguous", 8 };
+
+      test.execute( Push { "abcd" } );
+      test.execute( PeekAll { "abcd", "" } );
+      test.execute( Pop { 1 } );
+      test.execute( PeekAll { "bcd", "" } );
+      test.execute( PeekOnce { "bcd" } );
+    }
+
+    {
+      ByteStreamTestHarness test { "peek_all-wraparound", 8 };
+
+      test.execute( Push { "abcdef" } );
+      test.execute( Pop { 5 } );
+      test.execute( Push { "ghijk" } );
+
+      test.execute( BytesBuffered { 6 } );
+      test.execute( PeekOnce { "fgh" } );
+      test.execute( PeekAll { "fgh", "ijk" } );
+      test.execute( Peek { "fghijk" } );
+
+      test.execute( Pop { 4 } );
+      test.execute( PeekAll { "jk", "" } );
+    }
+
+    {
+      ByteStreamTestHarness test { "peek_all-full", 4 };
+
+      test.execute( Push { "ab" } );
+      test.execute( Pop { 2 } );
+      test.execute( Push { "cdef" } );
+
+      test.execute( AvailableCapacity { 0 } );
+      test.execute( PeekAll { "cd", "ef" } );
+      test.execute( ReadAll { "cdef" } );
+      test.execute( PeekAll { "", "" } );
+    }
+
+    {
+      const string first( 4000, 'x' );
+      const string wrapped = "abcdefghijklmnopqrstuvwxyz" + string( 200, 'y' );
+
+      ByteStreamTestHarness test { "peek-mirrored-wraparound", 4096, ByteStream::Storage::Mirrored };
+
+      test.execute( Push { first } );
+      test.execute( Pop { 4000 } );
+      test.execute( ReserveSize { 5000, 4096 } );
+      test.execute( ReserveCommit { wrapped } );
+
+      test.execute( BytesBuffered { wrapped.size() } );
+      test.execute( AvailableCapacity { 4096 - wrapped.size() } );
+      test.execute( PeekOnce { wrapped } );
+      test.execute( PeekAll { wrapped, "" } );
+
+      test.execute( Pop { 26 } );
+      test.execute( PeekOnce { string( 200, 'y' ) } );
+    }
+  } catch ( const exception& e ) {
+    cerr << "Exception: " << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,88 @@
+#include "byte_stream.hh"
+#include "byte_stream_test_harness.hh"
+
+#include <exception>
+#include <iostream>
+
+using namespace std;
+
+int main()
+{
+  try {
+    {
+      ByteStreamTestHarness test { "reserve-commit", 15 };
+
+      test.execute( ReserveSize { 4, 4 } );
+      test.execute( ReserveSize { 100, 15 } );
+      test.execute( BytesPushed { 0 } );
+      test.execute( BufferEmpty { true } );
+
+      test.execute( ReserveCommit { "cat" } );
+
+      test.execute( BytesPushed { 3 } );
+      test.execute( AvailableCapacity { 12 } );
+      test.execute( BytesBuffered { 3 } );
+      test.execute( Peek { "cat" } );
+
+      test.execute( ReserveCommit { "tac", 10 } );
+
+      test.execute( BytesPushed { 6 } );
+      test.execute( AvailableCapacity { 9 } );
+      test.execute( Peek { "cattac" } );
+    }
+
+    {
+      ByteStreamTestHarness test { "reserve-wraparound", 8 };
+
+      test.execute( Push { "abcdef" } );
+      test.execute( Pop { 4 } );
+      test.execute( ReserveSize { 8, 6 } );
+
+      test.execute( ReserveCommit { "ghijkl" } );
+
+      test.execute( BytesPushed { 12 } );
+      test.execute( AvailableCapacity { 0 } );
+      test.execute( BytesBuffered { 8 } );
+      test.execute( Peek { "efghijkl" } );
+      test.execute( ReadAll { "efghijkl" } );
+    }
+
+    {
+      ByteStreamTestHarness test { "commit-clamped-to-capacity", 4 };
+
+      test.execute( ReserveCommit { "abcdefgh" } );
+
+      test.execute( BytesPushed { 4 } );
+      test.execute( AvailableCapacity { 0 } );
+      test.execute( ReserveSize { 4, 0 } );
+      test.execute( Peek { "abcd" } );
+    }
+
+    {
+      ByteStreamTestHarness test { "reserve-after-close", 15 };
+
+      test.execute( ReserveCommit { "cat" } );
+      test.execute( Close {} );
+
+      test.execute( ReserveSize { 4, 0 } );
+      test.execute( ReserveCommit { "tac" } );
+      test.execute( BytesPushed { 3 } );
+      test.execute( Peek { "cat" } );
+    }
+
+    {
+      ByteStreamTestHarness test { "reserve-after-error", 15 };
+
+      test.execute( SetError {} );
+
+      test.execute( ReserveSize { 4, 0 } );
+      test.execute( ReserveCommit { "cat" } );
+      test.execute( BytesPushed { 0 } );
+    }
+  } catch ( const exception& e ) {
+    cerr << "Exception: " << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -15,7 +15,9 @@ void speed_test( const size_t input_len,   // NOLINT(bugprone-easily-swappable-p
                  const size_t capacity,    // NOLINT(bugprone-easily-swappable-parameters)
                  const size_t random_seed, // NOLINT(bugprone-easily-swappable-parameters)
                  const size_t write_size,  // NOLINT(bugprone-easily-swappable-parameters)
-                 const size_t read_size )  // NOLINT(bugprone-easily-swappable-parameters)
+                 const size_t read_size,   // NOLINT(bugprone-easily-swappable-parameters)
+                 const ByteStream::Storage storage,
+                 const string& storage_name )
 {
   // Generate the data to be written
   const string data = [&random_seed, &input_len] {
@@ -34,7 +36,7 @@ void speed_test( const size_t input_len,   // NOLINT(bugprone-easily-swappable-p
     split_data.emplace( data.substr( i, write_size ) );
   }
 
-  ByteStream bs { capacity };
+  ByteStream bs { capacity, storage };
   string output_data;
   output_data.reserve( data.size() );
 
@@ -75,11 +77,12 @@ void speed_test( const size_t input_len,   // NOLINT(bugprone-easily-swappable-p
   fstream debug_output;
   debug_output.open( "/dev/tty" );
 
-  cout << "ByteStream with capacity=" << capacity << ", write_size=" << write_size << ", read_size=" << read_size
-       << " reached " << fixed << setprecision( 2 ) << gigabits_per_second << " Gbit/s.\n";
+  cout << "ByteStream (" << storage_name << ") with capacity=" << capacity << ", write_size=" << write_size
+       << ", read_size=" << read_size << " reached " << fixed << setprecision( 2 ) << gigabits_per_second
+       << " Gbit/s.\n";
 
-  debug_output << "             ByteStream throughput: " << fixed << setprecision( 2 ) << gigabits_per_second
-               << " Gbit/s\n";
+  debug_output << "             ByteStream throughput (" << storage_name << "): " << fixed << setprecision( 2 )
+               << gigabits_per_second << " Gbit/s\n";
 
   if ( gigabits_per_second < 0.1 ) {
     throw runtime_error( "ByteStream did not meet minimum speed of 0.1 Gbit/s." );
@@ -88,7 +91,11 @@ void speed_test( const size_t input_len,   // NOLINT(bugprone-easily-swappable-p
 
 void program_body()
 {
-  speed_test( 1e7, 32768, 789, 1500, 128 );
+  speed_test( 1e7, 32768, 789, 1500, 128, ByteStream::Storage::Exact, "exact" );
+  speed_test( 1e7, 32768, 789, 1500, 128, ByteStream::Storage::PowerOfTwo, "power-of-two" );
+  speed_test( 1e7, 30000, 789, 1500, 128, ByteStream::Storage::Exact, "exact" );
+  speed_test( 1e7, 30000, 789, 1500, 128, ByteStream::Storage::PowerOfTwo, "power-of-two" );
+  speed_test( 1e7, 32768, 789, 1500, 128, ByteStream::Storage::Mirrored, "mirrored" );
 }
 
 int main()
@@ -3,6 +3,7 @@
 #include "byte_stream.hh"
 #include "common.hh"
 
+#include <algorithm>
 #include <concepts>
 #include <optional>
 #include <utility>
@@ -13,6 +14,19 @@ static_assert( sizeof( Reader ) == sizeof( ByteStream ),
 static_assert( sizeof( Writer ) == sizeof( ByteStream ),
                "Please add member variables to the ByteStream base, not the ByteStream Writer." );
 
+inline std::string to_string( ByteStream::Storage storage )
+{
+  switch ( storage ) {
+    case ByteStream::Storage::Exact:
+      return "exact";
+    case ByteStream::Storage::PowerOfTwo:
+      return "power-of-two";
+    case ByteStream::Storage::Mirrored:
+      return "mirrored";
+  }
+  return "unknown";
+}
+
 class ByteStreamTestHarness : public TestHarness<ByteStream>
 {
 public:
@@ -20,6 +34,12 @@ public:
     : TestHarness( move( test_name ), "capacity=" + std::to_string( capacity ), ByteStream { capacity } )
   {}
 
+  ByteStreamTestHarness( std::string test_name, uint64_t capacity, ByteStream::Storage storage )
+    : TestHarness( move( test_name ),
+                   "capacity=" + std::to_string( capacity ) + ", storage=" + to_string( storage ),
+                   ByteStream { capacity, storage } )
+  {}
+
   size_t peek_size() { return object().reader().peek().size(); }
 };
 
@@ -55,6 +75,35 @@ struct Pop : public Action<ByteStream>
   void execute( ByteStream& bs ) const override { bs.reader().pop( len_ ); }
 };
 
+struct ReserveCommit : public Action<ByteStream>
+{
+  std::string data_;
+  uint64_t reserve_len_;
+
+  explicit ReserveCommit( std::string data ) : data_( move( data ) ), reserve_len_( data_.size() ) {}
+  ReserveCommit( std::string data, uint64_t reserve_len ) : data_( move( data ) ), reserve_len_( reserve_len ) {}
+
+  std::string description() const override
+  {
+    return "reserve( " + std::to_string( reserve_len_ ) + " ), write \"" + Printer::prettify( data_ )
+           + "\" and commit";
+  }
+
+  void execute( ByteStream& bs ) const override
+  {
+    auto spans = bs.writer().reserve( reserve_len_ );
+    std::string_view remaining = data_;
+    uint64_t written = 0;
+    for ( auto span : spans ) {
+      const auto chunk = remaining.substr( 0, span.size() );
+      std::copy( chunk.begin(), chunk.end(), span.begin() );
+      remaining.remove_prefix( chunk.size() );
+      written += chunk.size();
+    }
+    bs.writer().commit( written );
+  }
+};
+
 /* expectations */
 
 struct Peek : public Expectation<ByteStream>
@@ -107,6 +156,52 @@ struct PeekOnce : public Peek
   }
 };
 
+struct ReserveSize : public Expectation<ByteStream>
+{
+  uint64_t len_;
+  uint64_t size_;
+
+  ReserveSize( uint64_t len, uint64_t size ) : len_( len ), size_( size ) {}
+
+  std::string description() const override
+  {
+    return "reserve( " + std::to_string( len_ ) + " ) gives " + std::to_string( size_ ) + " writable bytes";
+  }
+
+  void execute( ByteStream& bs ) const override
+  {
+    const auto spans = bs.writer().reserve( len_ );
+    const uint64_t got = spans[0].size() + spans[1].size();
+    if ( got != size_ ) {
+      throw ExpectationViolation { "reserved bytes", size_, got };
+    }
+  }
+};
+
+struct PeekAll : public Expectation<ByteStream>
+{
+  std::string first_;
+  std::string second_;
+
+  PeekAll( std::string first, std::string second ) : first_( move( first ) ), second_( move( second ) ) {}
+
+  std::string description() const override
+  {
+    return "peek_all() gives \"" + Printer::prettify( first_ ) + "\" and \"" + Printer::prettify( second_ ) + "\"";
+  }
+
+  void execute( ByteStream& bs ) const override
+  {
+    const auto peeked = bs.reader().peek_all();
+    if ( peeked[0] != first_ or peeked[1] != second_ ) {
+      throw ExpectationViolation { "Expected \"" + Printer::prettify( first_ ) + "\" and \""
+                                   + Printer::prettify( second_ ) + "\", but found \""
+                                   + Printer::prettify( peeked[0] ) + "\" and \"" + Printer::prettify( peeked[1] )
+                                   + "\"" };
+    }
+  }
+};
+
 struct IsClosed : public ConstExpectBool<ByteStream>
 {
   using ConstExpectBool::ConstExpectBool;
@@ -0,0 +1,70 @@
+#include "checksum.hh"
+#include "ipv4_header.hh"
+#include "random.hh"
+#include "test_should_be.hh"
+
+#include <cstdint>
+#include <exception>
+#include <iostream>
+
+using namespace std;
+
+static IPv4Header random_header( default_random_engine& rd )
+{
+  IPv4Header h;
+  h.tos = rd();
+  h.len = rd();
+  h.id = rd();
+  h.df = rd() % 2;
+  h.offset = rd() & 0x1fff;
+  h.ttl = 1 + rd() % 255;
+  h.proto = rd();
+  h.src = rd();
+  h.dst = rd();
+  h.compute_checksum();
+  return h;
+}
+
+int main()
+{
+  try {
+    auto rd = get_random_engine();
+
+    // TTL decrements, all the way down to zero
+    for ( size_t rep = 0; rep < 1000; ++rep ) {
+      IPv4Header h = random_header( rd );
+      while ( h.ttl > 0 ) {
+        h.decrement_ttl();
+        const uint16_t incremental = h.cksum;
+        h.compute_checksum();
+        test_should_be( incremental, h.cksum );
+      }
+    }
+
+    // arbitrary 16-bit and 32-bit field rewrites
+    for ( size_t rep = 0; rep < 100000; ++rep ) {
+      IPv4Header h = random_header( rd );
+
+      const uint16_t old_id = h.id;
+      h.id = rd();
+      const uint16_t after_id = InternetChecksum::adjust( h.cksum, old_id, h.id );
+      h.compute_checksum();
+      test_should_be( after_id, h.cksum );
+
+      const uint32_t old_src = h.src;
+      h.src = rd();
+      const uint16_t after_src = InternetChecksum::adjust32( h.cksum, old_src, h.src );
+      h.compute_checksum();
+      test_should_be( after_src, h.cksum );
+    }
+
+    // a rewrite that leaves the field unchanged leaves the checksum unchanged
+    IPv4Header h = random_header( rd );
+    test_should_be( InternetChecksum::adjust( h.cksum, h.id, h.id ), h.cksum );
+  } catch ( const exception& e ) {
+    cerr << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,107 @@
+#include "checksum.hh"
+#include "random.hh"
+#include "test_should_be.hh"
+
+#include <algorithm>
+#include <cstdint>
+#include <exception>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+using namespace std;
+
+// The original byte-at-a-time algorithm, as an independent reference
+static uint16_t reference_checksum( uint32_t initial_sum, const vector<string_view>& pieces )
+{
+  uint32_t sum = initial_sum;
+  bool parity = false;
+  for ( const auto piece : pieces ) {
+    for ( const uint8_t byte : piece ) {
+      sum += parity ? byte : static_cast<uint32_t>( byte ) << 8;
+      parity = !parity;
+    }
+  }
+  while ( sum > 0xffff ) {
+    sum = ( sum >> 16 ) + static_cast<uint16_t>( sum );
+  }
+  return ~sum;
+}
+
+static constexpr InternetChecksum::Kernel KERNELS[] = { InternetChecksum::Kernel::Bytewise,
+                                                        InternetChecksum::Kernel::Word64,
+                                                        InternetChecksum::Kernel::SSE2,
+                                                        InternetChecksum::Kernel::AVX2 };
+
+static void check_all_kernels( uint32_t initial_sum, const vector<string_view>& pieces )
+{
+  const uint16_t expected = reference_checksum( initial_sum, pieces );
+
+  for ( const auto kernel : KERNELS ) {
+    if ( not InternetChecksum::supported( kernel ) ) {
+      continue;
+    }
+    InternetChecksum check { initial_sum };
+    for ( const auto piece : pieces ) {
+      check.add( piece, kernel );
+    }
+    test_should_be( check.value(), expected );
+  }
+
+  // default (runtime-selected) kernel
+  InternetChecksum check { initial_sum };
+  for ( const auto piece : pieces ) {
+    check.add( piece );
+  }
+  test_should_be( check.value(), expected );
+}
+
+int main()
+{
+  try {
+    auto rd = get_random_engine();
+
+    // empty, all-zero and all-ones inputs
+    check_all_kernels( 0, {} );
+    check_all_kernels( 0, { "" } );
+    const string zeros( 1001, '\0' );
+    const string ones( 1001, '\xff' );
+    for ( size_t len = 0; len < 80; ++len ) {
+      check_all_kernels( 0, { string_view { zeros }.substr( 0, len ) } );
+      check_all_kernels( 0, { string_view { ones }.substr( 0, len ) } );
+    }
+
+    // every length (odd and even) and alignment up to a few vector widths
+    string data( 4096, 0 );
+    generate( data.begin(), data.end(), [&] { return rd(); } );
+    for ( size_t offset = 0; offset < 8; ++offset ) {
+      for ( size_t len = 0; len < 200; ++len ) {
+        check_all_kernels( rd() & 0xffff, { string_view { data }.substr( offset, len ) } );
+      }
+    }
+
+    // data split into random pieces, so that pieces start at odd offsets of the stream
+    for ( size_t rep = 0; rep < 2000; ++rep ) {
+      vector<string_view> pieces;
+      size_t pos = rd() % 16;
+      const size_t num_pieces = 1 + rd() % 6;
+      for ( size_t i = 0; i < num_pieces; ++i ) {
+        const size_t len = min<size_t>( rd() % 700, data.size() - pos );
+        pieces.push_back( string_view { data }.substr( pos, len ) );
+        pos += len;
+      }
+      check_all_kernels( rd() % 0x100000, pieces );
+    }
+
+    // a full-size (64 KiB) payload
+    string big( 65535, 0 );
+    generate( big.begin(), big.end(), [&] { return rd(); } );
+    check_all_kernels( 0, { big } );
+  } catch ( const exception& e ) {
+    cerr << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,98 @@
+#include "checksum.hh"
+
+#include <chrono>
+#include <cstddef>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+
+using namespace std;
+using namespace std::chrono;
+
+static string kernel_name( InternetChecksum::Kernel kernel )
+{
+  switch ( kernel ) {
+    case InternetChecksum::Kernel::Bytewise:
+      return "bytewise";
+    case InternetChecksum::Kernel::Word64:
+      return "64-bit words";
+    case InternetChecksum::Kernel::SSE2:
+      return "SSE2";
+    case InternetChecksum::Kernel::AVX2:
+      return "AVX2";
+  }
+  return "unknown";
+}
+
+// Checksum `total_bytes` in `buffer_size`-byte pieces (e.g. one TCP payload at a time)
+double speed_test( const InternetChecksum::Kernel kernel, const size_t buffer_size, const size_t total_bytes )
+{
+  default_random_engine rd { 1373 };
+  uniform_int_distribution<char> ud;
+  string data( buffer_size, 0 );
+  for ( auto& ch : data ) {
+    ch = ud( rd );
+  }
+
+  uint64_t total = 0;
+  const size_t reps = total_bytes / buffer_size;
+  const auto start_time = steady_clock::now();
+  for ( size_t i = 0; i < reps; ++i ) {
+    InternetChecksum check;
+    check.add( data, kernel );
+    total += check.value();
+  }
+  const auto stop_time = steady_clock::now();
+
+  if ( total == 0 ) {
+    throw runtime_error( "unexpected checksum" );
+  }
+
+  auto test_duration = duration_cast<duration<double>>( stop_time - start_time );
+  auto gigabits_per_second = 8 * static_cast<double>( reps * buffer_size ) / test_duration.count() / 1e9;
+
+  fstream debug_output;
+  debug_output.open( "/dev/tty" );
+
+  cout << "InternetChecksum (" << kernel_name( kernel ) << ", " << buffer_size << "-byte buffers) reached "
+       << fixed << setprecision( 2 ) << gigabits_per_second << " Gbit/s.\n";
+
+  debug_output << "   InternetChecksum throughput (" << kernel_name( kernel ) << ", " << buffer_size
+               << " bytes): " << fixed << setprecision( 2 ) << gigabits_per_second << " Gbit/s\n";
+
+  return gigabits_per_second;
+}
+
+void program_body()
+{
+  const auto best = InternetChecksum::best_kernel();
+  for ( const auto kernel : { InternetChecksum::Kernel::Bytewise,
+                              InternetChecksum::Kernel::Word64,
+                              InternetChecksum::Kernel::SSE2,
+                              InternetChecksum::Kernel::AVX2 } ) {
+    if ( not InternetChecksum::supported( kernel ) ) {
+      continue;
+    }
+    const size_t total = kernel == InternetChecksum::Kernel::Bytewise ? 100'000'000 : 1'000'000'000;
+    speed_test( kernel, 1000, total );
+    const double gbps = speed_test( kernel, 65535, total );
+
+    if ( kernel == best and gbps < 10 ) {
+      throw runtime_error( "InternetChecksum did not meet minimum speed of 10 Gbit/s." );
+    }
+  }
+}
+
+int main()
+{
+  try {
+    program_body();
+  } catch ( const exception& e ) {
+    cerr << "Exception: " << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
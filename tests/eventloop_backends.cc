@@ -0,0 +1,300 @@
+#include "eventloop.hh"
+#include "exception.hh"
+
+#include <algorithm>
+#include <array>
+#include <cstdio>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <numeric>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+namespace {
+
+void expect( bool condition, const string& msg )
+{
+  if ( not condition ) {
+    throw runtime_error( msg );
+  }
+}
+
+pair<FileDescriptor, FileDescriptor> make_pipe()
+{
+  array<int, 2> fds {};
+  CheckSystemCall( "pipe", ::pipe( fds.data() ) );
+  return { FileDescriptor { fds[0] }, FileDescriptor { fds[1] } };
+}
+
+pair<FileDescriptor, FileDescriptor> make_socket_pair()
+{
+  array<int, 2> fds {};
+  CheckSystemCall( "socketpair", ::socketpair( AF_UNIX, SOCK_STREAM, 0, fds.data() ) );
+  return { FileDescriptor { fds[0] }, FileDescriptor { fds[1] } };
+}
+
+// A writer rule feeds a pipe, and closes it when done; the reader rule sees EOF and is cancelled.
+void pipe_test( const EventLoop::Backend backend )
+{
+  EventLoop loop { backend };
+  auto [read_end, write_end] = make_pipe();
+
+  const size_t messages = 100;
+  size_t written = 0;
+  string received;
+  bool reader_cancelled = false;
+
+  loop.add_rule(
+    "write to pipe",
+    write_end,
+    Direction::Out,
+    [&] {
+      write_end.write( "x" );
+      if ( ++written == messages ) {
+        write_end.close();
+      }
+    },
+    [&] { return written < messages; } );
+
+  loop.add_rule(
+    "read from pipe",
+    read_end,
+    Direction::In,
+    [&] {
+      string buf;
+      read_end.read( buf );
+      received += buf;
+    },
+    [] { return true; },
+    [&] { reader_cancelled = true; } );
+
+  while ( loop.wait_next_event( 1000 ) == EventLoop::Result::Success ) {}
+
+  expect( received == string( messages, 'x' ), "pipe: data mismatch" );
+  expect( reader_cancelled, "pipe: reader should be cancelled at EOF" );
+}
+
+// An In and an Out rule on the same fd (the two backends must not confuse them), talking to an echo on the
+// other end of a socketpair.
+void same_fd_test( const EventLoop::Backend backend )
+{
+  EventLoop loop { backend };
+  auto [near, far] = make_socket_pair();
+
+  const size_t rounds = 50;
+  size_t pings_sent = 0;
+  size_t pongs_received = 0;
+  string to_echo;
+
+  auto ping = loop.add_rule(
+    "send ping",
+    near,
+    Direction::Out,
+    [&] {
+      near.write( "p" );
+      ++pings_sent;
+    },
+    [&] { return pings_sent == pongs_received and pings_sent < rounds; } );
+
+  auto pong = loop.add_rule( "receive pong", near, Direction::In, [&] {
+    string buf;
+    near.read( buf );
+    pongs_received += buf.size();
+  } );
+
+  auto echo_in = loop.add_rule(
+    "echo: read",
+    far,
+    Direction::In,
+    [&] {
+      string buf;
+      far.read( buf );
+      to_echo += buf;
+    },
+    [&] { return to_echo.empty(); } );
+
+  auto echo_out = loop.add_rule(
+    "echo: write",
+    far,
+    Direction::Out,
+    [&] { to_echo.erase( 0, far.write( to_echo ) ); },
+    [&] { return not to_echo.empty(); } );
+
+  while ( pongs_received < rounds ) {
+    expect( loop.wait_next_event( 1000 ) == EventLoop::Result::Success, "same fd: loop stalled" );
+  }
+
+  // cancelled rules are dropped, and a loop with no rules left has nothing to wait for
+  ping.cancel();
+  pong.cancel();
+  echo_in.cancel();
+  echo_out.cancel();
+  expect( loop.wait_next_event( 0 ) == EventLoop::Result::Exit, "same fd: loop should exit" );
+  expect( pings_sent == rounds, "same fd: wrong number of pings" );
+}
+
+// Nothing to read: the wait times out
+void timeout_test( const EventLoop::Backend backend )
+{
+  EventLoop loop { backend };
+  auto [read_end, write_end] = make_pipe();
+  loop.add_rule( "read from pipe", read_end, Direction::In, [&] {
+    string buf;
+    read_end.read( buf );
+  } );
+
+  expect( loop.wait_next_event( 10 ) == EventLoop::Result::Timeout, "timeout: expected a timeout" );
+  write_end.write( "x" );
+  expect( loop.wait_next_event( 10 ) == EventLoop::Result::Success, "timeout: expected the rule to fire" );
+  expect( loop.wait_next_event( 10 ) == EventLoop::Result::Timeout, "timeout: expected another timeout" );
+}
+
+// Many fds, few of them ready at a time
+void many_fds_test( const EventLoop::Backend backend )
+{
+  EventLoop loop { backend };
+  const size_t num_pipes = 250;
+
+  vector<pair<FileDescriptor, FileDescriptor>> pipes;
+  vector<size_t> served( num_pipes );
+  vector<EventLoop::RuleHandle> handles;
+  const size_t category = loop.add_category( "read pipe" );
+  for ( size_t i = 0; i < num_pipes; ++i ) {
+    pipes.push_back( make_pipe() );
+    handles.push_back( loop.add_rule( category, pipes.back().first, Direction::In, [&, i] {
+      string buf;
+      pipes[i].first.read( buf );
+      served[i] += buf.size();
+    } ) );
+  }
+
+  size_t num_written = 0;
+  for ( size_t i = 0; i < num_pipes; i += 7 ) {
+    pipes[i].second.write( "x" );
+    ++num_written;
+  }
+  // (poll and epoll serve one rule per wait; io_uring serves everything that completed)
+  while ( accumulate( served.begin(), served.end(), size_t { 0 } ) < num_written ) {
+    expect( loop.wait_next_event( 1000 ) == EventLoop::Result::Success, "many fds: expected a ready fd" );
+  }
+  expect( loop.wait_next_event( 0 ) == EventLoop::Result::Timeout, "many fds: expected no more ready fds" );
+
+  for ( size_t i = 0; i < num_pipes; ++i ) {
+    expect( served[i] == ( i % 7 == 0 ? 1 : 0 ), "many fds: wrong fd served" );
+  }
+
+  for ( auto& handle : handles ) {
+    handle.cancel();
+  }
+  expect( loop.wait_next_event( 0 ) == EventLoop::Result::Exit, "many fds: loop should exit" );
+}
+
+// A regular file (which epoll refuses) is always ready, as with poll
+void regular_file_test( const EventLoop::Backend backend )
+{
+  EventLoop loop { backend };
+  FILE* const file = tmpfile();
+  expect( file != nullptr, "tmpfile failed" );
+  FileDescriptor fd { CheckSystemCall( "dup", ::dup( fileno( file ) ) ) };
+  fclose( file );
+  fd.write( "hello" );
+  CheckSystemCall( "lseek", static_cast<int>( ::lseek( fd.fd_num(), 0, SEEK_SET ) ) );
+
+  string contents;
+  loop.add_rule( "read file", fd, Direction::In, [&] {
+    string buf;
+    fd.read( buf );
+    contents += buf;
+  } );
+
+  while ( loop.wait_next_event( 1000 ) == EventLoop::Result::Success ) {}
+  expect( contents == "hello", "regular file: data mismatch" );
+}
+
+// Read and write rules, whose I/O the loop performs itself, moving data through a socketpair. The reader's
+// space keeps changing size, so (with io_uring) a completed read does not always fit and is handed over in parts.
+void io_rules_test( const EventLoop::Backend backend )
+{
+  EventLoop loop { backend };
+  auto [near, far] = make_socket_pair();
+
+  string data;
+  for ( size_t i = 0; i < 300000; ++i ) {
+    data.push_back( static_cast<char>( 'a' + i % 23 ) );
+  }
+  size_t sent = 0;
+  string received( data.size() + 1000, '\0' ); // room to spare, so the reader stays interested until EOF
+  size_t received_size = 0;
+  size_t space_calls = 0;
+  bool reader_cancelled = false;
+
+  loop.register_memory( received ); // the reads use a fixed buffer with io_uring, the writes plain memory
+
+  loop.add_write_rule(
+    "write to socket",
+    near,
+    [&]() -> array<string_view, 2> {
+      const string_view rest = string_view { data }.substr( sent );
+      return { rest.substr( 0, 5000 ), rest.substr( min( rest.size(), size_t { 5000 } ), 7000 ) };
+    },
+    [&]( const size_t n ) {
+      sent += n;
+      if ( sent == data.size() ) {
+        near.close();
+      }
+    } );
+
+  loop.add_read_rule(
+    "read from socket",
+    far,
+    [&]() -> array<span<char>, 2> {
+      const size_t cap = ( ++space_calls % 2 ) ? 3000 : 1000;
+      const size_t n = min( cap, received.size() - received_size );
+      return { span<char> { received.data() + received_size, n / 2 },
+               span<char> { received.data() + received_size + n / 2, n - n / 2 } };
+    },
+    [&]( const size_t n ) { received_size += n; },
+    [] { return true; },
+    [&] { reader_cancelled = true; } );
+
+  while ( loop.wait_next_event( 1000 ) == EventLoop::Result::Success ) {}
+
+  expect( sent == data.size(), "io rules: not everything was sent" );
+  expect( received_size == data.size() and received.substr( 0, received_size ) == data, "io rules: data mismatch" );
+  expect( reader_cancelled, "io rules: reader should be cancelled at EOF" );
+}
+
+} // namespace
+
+int main()
+{
+  try {
+    // io_uring may be unavailable (or disabled) here, in which case the loop falls back to epoll
+    const auto uring_backend = EventLoop { EventLoop::Backend::IoUring }.backend();
+    expect( uring_backend == EventLoop::Backend::IoUring or uring_backend == EventLoop::Backend::Epoll,
+            "io_uring backend should fall back to epoll" );
+
+    for ( const auto backend : { EventLoop::Backend::Poll, EventLoop::Backend::Epoll, EventLoop::Backend::IoUring } ) {
+      pipe_test( backend );
+      same_fd_test( backend );
+      timeout_test( backend );
+      many_fds_test( backend );
+      regular_file_test( backend );
+      io_rules_test( backend );
+    }
+  } catch ( const exception& e ) {
+    cerr << "Exception: " << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,190 @@
+#include "eventloop.hh"
+#include "exception.hh"
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <sys/socket.h>
+#include <utility>
+#include <vector>
+
+using namespace std;
+using namespace std::chrono;
+
+// The EventLoop backends compared: bulk transfer through read and write rules (where io_uring can do the I/O
+// without a syscall per operation), and many quiet fds with one active at a time (where poll rescans them all).
+
+static constexpr size_t NUM_STREAMS = 8;
+static constexpr size_t BYTES_PER_STREAM = 32 << 20;
+static constexpr size_t CHUNK_SIZE = 64 << 10;
+static constexpr size_t NUM_QUIET_FDS = 300;
+static constexpr size_t NUM_HOPS = 50000;
+static constexpr double MIN_GBITS_PER_SEC = 0.5;
+static constexpr double MIN_EVENTS_PER_SEC = 1e4;
+
+static pair<FileDescriptor, FileDescriptor> make_socket_pair()
+{
+  array<int, 2> fds {};
+  CheckSystemCall( "socketpair", ::socketpair( AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0, fds.data() ) );
+  return { FileDescriptor { fds[0] }, FileDescriptor { fds[1] } };
+}
+
+static string backend_name( const EventLoop::Backend backend )
+{
+  switch ( backend ) {
+    case EventLoop::Backend::Poll:
+      return "poll";
+    case EventLoop::Backend::Epoll:
+      return "epoll";
+    case EventLoop::Backend::IoUring:
+      return "io_uring";
+  }
+  return "unknown";
+}
+
+// Every stream writes BYTES_PER_STREAM into one end of a socketpair, and reads them from the other
+static double bulk_gbits_per_sec( EventLoop& loop )
+{
+  string chunk( CHUNK_SIZE, 'x' );
+  vector<pair<FileDescriptor, FileDescriptor>> pairs;
+  vector<size_t> sent( NUM_STREAMS ), received( NUM_STREAMS );
+  vector<string> buffers( NUM_STREAMS, string( CHUNK_SIZE, '\0' ) );
+  pairs.reserve( NUM_STREAMS );
+
+  loop.register_memory( chunk );
+  for ( auto& buffer : buffers ) {
+    loop.register_memory( buffer );
+  }
+
+  const size_t write_category = loop.add_category( "write stream" );
+  const size_t read_category = loop.add_category( "read stream" );
+  for ( size_t i = 0; i < NUM_STREAMS; ++i ) {
+    pairs.push_back( make_socket_pair() );
+    loop.add_write_rule(
+      write_category,
+      pairs[i].first,
+      [&, i]() -> array<string_view, 2> {
+        return { string_view { chunk }.substr( 0, BYTES_PER_STREAM - sent[i] ), {} };
+      },
+      [&, i]( const size_t n ) {
+        sent[i] += n;
+        if ( sent[i] == BYTES_PER_STREAM ) {
+          pairs[i].first.close();
+        }
+      } );
+    loop.add_read_rule(
+      read_category,
+      pairs[i].second,
+      [&, i]() -> array<span<char>, 2> { return { span { buffers[i] }, {} }; },
+      [&, i]( const size_t n ) { received[i] += n; } );
+  }
+
+  const auto start_time = steady_clock::now();
+  while ( loop.wait_next_event( 1000 ) == EventLoop::Result::Success ) {}
+  const auto stop_time = steady_clock::now();
+
+  for ( size_t i = 0; i < NUM_STREAMS; ++i ) {
+    if ( received[i] != BYTES_PER_STREAM ) {
+      throw runtime_error( "Bulk transfer lost data." );
+    }
+  }
+
+  return NUM_STREAMS * BYTES_PER_STREAM * 8 / duration_cast<duration<double>>( stop_time - start_time ).count()
+         / 1e9;
+}
+
+// A token passed around a ring of socketpairs: each event reads it from one and writes it into the next
+static double sparse_events_per_sec( EventLoop& loop )
+{
+  vector<pair<FileDescriptor, FileDescriptor>> pairs;
+  vector<EventLoop::RuleHandle> handles;
+  pairs.reserve( NUM_QUIET_FDS );
+  size_t hops = 0;
+
+  const size_t category = loop.add_category( "pass token" );
+  for ( size_t i = 0; i < NUM_QUIET_FDS; ++i ) {
+    pairs.push_back( make_socket_pair() );
+  }
+  for ( size_t i = 0; i < NUM_QUIET_FDS; ++i ) {
+    handles.push_back( loop.add_rule( category, pairs[i].second, Direction::In, [&, i] {
+      string buf;
+      pairs[i].second.read( buf );
+      if ( ++hops < NUM_HOPS ) {
+        pairs[( i + 1 ) % NUM_QUIET_FDS].first.write( buf );
+      }
+    } ) );
+  }
+
+  pairs[0].first.write( "t" );
+  const auto start_time = steady_clock::now();
+  while ( hops < NUM_HOPS ) {
+    if ( loop.wait_next_event( 1000 ) != EventLoop::Result::Success ) {
+      throw runtime_error( "Token was lost." );
+    }
+  }
+  const auto stop_time = steady_clock::now();
+
+  for ( auto& handle : handles ) {
+    handle.cancel();
+  }
+
+  return NUM_HOPS / duration_cast<duration<double>>( stop_time - start_time ).count();
+}
+
+static void benchmark( const EventLoop::Backend backend )
+{
+  double gbits_per_sec {};
+  double events_per_sec {};
+  EventLoop::Backend effective {};
+  {
+    EventLoop loop { backend };
+    effective = loop.backend();
+    gbits_per_sec = bulk_gbits_per_sec( loop );
+  }
+  {
+    EventLoop loop { backend };
+    events_per_sec = sparse_events_per_sec( loop );
+  }
+
+  const string name
+    = backend_name( backend ) + ( effective == backend ? "" : " (unavailable, using " + backend_name( effective ) + ")" );
+
+  fstream debug_output;
+  debug_output.open( "/dev/tty" );
+
+  cout << "EventLoop (" << name << ") moved " << fixed << setprecision( 2 ) << gbits_per_sec << " Gbit/s over "
+       << NUM_STREAMS << " streams, and served " << setprecision( 0 ) << events_per_sec << " events/s with "
+       << NUM_QUIET_FDS << " fds, one active at a time.\n";
+  debug_output << "   " << name << " eventloop: " << fixed << setprecision( 2 ) << gbits_per_sec << " Gbit/s, "
+               << setprecision( 0 ) << events_per_sec << " events/s\n";
+
+  if ( gbits_per_sec < MIN_GBITS_PER_SEC or events_per_sec < MIN_EVENTS_PER_SEC ) {
+    throw runtime_error( "EventLoop is too slow." );
+  }
+}
+
+void program_body()
+{
+  for ( const auto backend : { EventLoop::Backend::Poll, EventLoop::Backend::Epoll, EventLoop::Backend::IoUring } ) {
+    benchmark( backend );
+  }
+}
+
+int main()
+{
+  try {
+    program_body();
+  } catch ( const exception& e ) {
+    cerr << "Exception: " << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,111 @@
+#include "ipv4_datagram.hh"
+#include "parser.hh"
+#include "tcp_segment.hh"
+
+#include <chrono>
+#include <cstddef>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+
+using namespace std;
+using namespace std::chrono;
+
+// A TCP segment inside an IPv4 datagram, serialized into one contiguous buffer (as if read from a socket)
+static string make_packet( const size_t payload_size, const size_t random_seed )
+{
+  default_random_engine rd { random_seed };
+  uniform_int_distribution<char> ud;
+
+  TCPSegment seg;
+  seg.udinfo.src_port = 1234;
+  seg.udinfo.dst_port = 80;
+  seg.message.sender.seqno = Wrap32 { 0x12345678 };
+  seg.message.receiver.ackno = Wrap32 { 0x9abcdef0 };
+  seg.message.receiver.window_size = 1000;
+  string payload( payload_size, 0 );
+  for ( auto& ch : payload ) {
+    ch = ud( rd );
+  }
+  seg.message.sender.payload = std::move( payload );
+
+  IPv4Datagram dgram;
+  dgram.header.src = 0x0a000001;
+  dgram.header.dst = 0x0a000002;
+  dgram.header.len = dgram.header.hlen * 4 + 20 + payload_size;
+  Serializer serializer;
+  seg.serialize_with_checksum( serializer, dgram.header.pseudo_checksum() );
+  dgram.header.compute_checksum();
+  dgram.payload = serializer.finish();
+
+  return serialize( dgram ).concatenate();
+}
+
+// Parse the IPv4 and TCP headers of the same packet repeatedly. With `split`, the packet arrives in
+// pieces whose boundaries fall inside header fields, so the parser has to take its slow path.
+void speed_test( const size_t num_packets, const size_t payload_size, const bool split )
+{
+  const string packet = make_packet( payload_size, 1372 );
+
+  BufferList input;
+  if ( split ) {
+    input.append( Buffer { packet.substr( 0, 7 ) } );
+    input.append( Buffer { packet.substr( 7, 25 ) } );
+    input.append( Buffer { packet.substr( 32 ) } );
+  } else {
+    input.append( Buffer { packet } );
+  }
+
+  uint64_t checksum_total = 0;
+  const auto start_time = steady_clock::now();
+  for ( size_t i = 0; i < num_packets; ++i ) {
+    IPv4Datagram dgram;
+    TCPSegment seg;
+    if ( not parse( dgram, input ) or not parse( seg, dgram.payload, dgram.header.pseudo_checksum() ) ) {
+      throw runtime_error( "failed to parse packet" );
+    }
+    checksum_total += seg.udinfo.cksum;
+  }
+  const auto stop_time = steady_clock::now();
+
+  if ( checksum_total == 0 ) {
+    throw runtime_error( "unexpected checksum" );
+  }
+
+  auto test_duration = duration_cast<duration<double>>( stop_time - start_time );
+  auto packets_per_second = static_cast<double>( num_packets ) / test_duration.count();
+
+  fstream debug_output;
+  debug_output.open( "/dev/tty" );
+
+  const string layout = split ? "split" : "contiguous";
+  cout << "IPv4+TCP header parsing (" << layout << ", " << payload_size << "-byte payload) reached " << fixed
+       << setprecision( 2 ) << packets_per_second / 1e6 << " million packets/s.\n";
+
+  debug_output << "   Header parsing throughput (" << layout << "): " << fixed << setprecision( 2 )
+               << packets_per_second / 1e6 << " million packets/s\n";
+
+  if ( packets_per_second < 5e5 ) {
+    throw runtime_error( "Header parsing did not meet minimum speed of 500k packets/s." );
+  }
+}
+
+void program_body()
+{
+  speed_test( 1000000, 16, false );
+  speed_test( 1000000, 16, true );
+}
+
+int main()
+{
+  try {
+    program_body();
+  } catch ( const exception& e ) {
+    cerr << "Exception: " << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
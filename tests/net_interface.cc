@@ -26,8 +26,8 @@ InternetDatagram make_datagram( const string& src_ip, const string& dst_ip ) //
   InternetDatagram dgram;
   dgram.header.src = Address( src_ip, 0 ).ipv4_numeric();
   dgram.header.dst = Address( dst_ip, 0 ).ipv4_numeric();
-  dgram.payload.emplace_back( "hello" );
-  dgram.header.len = static_cast<uint64_t>( dgram.header.hlen ) * 4 + dgram.payload.front().size();
+  dgram.payload.append( "hello" );
+  dgram.header.len = static_cast<uint64_t>( dgram.header.hlen ) * 4 + dgram.payload.size();
   dgram.header.compute_checksum();
   return dgram;
 }
@@ -50,7 +50,7 @@ ARPMessage make_arp( const uint16_t opcode,
 EthernetFrame make_frame( const EthernetAddress& src,
                           const EthernetAddress& dst,
                           const uint16_t type,
-                          vector<string> payload )
+                          BufferList payload )
 {
   EthernetFrame frame;
   frame.header.src = src;
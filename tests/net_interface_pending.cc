@@ -0,0 +1,227 @@
+#include "arp_message.hh"
+#include "network_interface_test_harness.hh"
+#include "test_should_be.hh"
+
+#include <cstdint>
+#include <exception>
+#include <iostream>
+#include <memory>
+#include <span>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+namespace {
+
+const EthernetAddress local_eth { 2, 0, 0, 0, 0, 1 };
+
+InternetDatagram make_datagram( const string& payload )
+{
+  InternetDatagram dgram;
+  dgram.header.src = Address( "4.3.2.1", 0 ).ipv4_numeric();
+  dgram.header.dst = Address( "13.12.11.10", 0 ).ipv4_numeric();
+  dgram.payload.append( payload );
+  dgram.header.len = static_cast<uint64_t>( dgram.header.hlen ) * 4 + dgram.payload.size();
+  dgram.header.compute_checksum();
+  return dgram;
+}
+
+EthernetFrame make_arp_reply( const EthernetAddress& sender_eth, const string& sender_ip )
+{
+  ARPMessage arp;
+  arp.opcode = ARPMessage::OPCODE_REPLY;
+  arp.sender_ethernet_address = sender_eth;
+  arp.sender_ip_address = Address( sender_ip, 0 ).ipv4_numeric();
+  arp.target_ethernet_address = local_eth;
+  arp.target_ip_address = Address( "4.3.2.1", 0 ).ipv4_numeric();
+  return { { local_eth, sender_eth, EthernetHeader::TYPE_ARP }, serialize( arp ) };
+}
+
+// Payloads of the IPv4 frames sent so far (and forget all frames)
+vector<string> sent_payloads( FramesOut& out )
+{
+  vector<string> ret;
+  while ( not out.frames.empty() ) {
+    const EthernetFrame frame = std::move( out.frames.front() );
+    out.frames.pop();
+    InternetDatagram dgram;
+    if ( frame.header.type == EthernetHeader::TYPE_IPv4 and parse( dgram, frame.payload ) ) {
+      ret.push_back( dgram.payload.concatenate() );
+    }
+  }
+  return ret;
+}
+
+// A port that records how frames arrive: one at a time or in batches
+class BatchCountingPort : public FramesOut
+{
+public:
+  std::vector<size_t> batches {};
+  void transmit_batch( const NetworkInterface& sender, std::span<const EthernetFrame> batch ) override
+  {
+    batches.push_back( batch.size() );
+    NetworkInterface::OutputPort::transmit_batch( sender, batch );
+  }
+};
+
+struct Setup
+{
+  shared_ptr<FramesOut> out { make_shared<FramesOut>() };
+  NetworkInterface iface { "test", out, local_eth, Address( "4.3.2.1", 0 ) };
+};
+
+} // namespace
+
+int main()
+{
+  try {
+    const EthernetAddress remote_eth { 2, 0, 0, 0, 0, 2 };
+    const EthernetAddress other_eth { 2, 0, 0, 0, 0, 3 };
+
+    // per-neighbor packet limit, dropping the newest
+    {
+      Setup s;
+      s.iface.set_pending_limits( { 2, 1 << 20, 1 << 20, 1 << 20, NetworkInterface::DropPolicy::DropNewest } );
+      for ( const auto* payload : { "a", "b", "c", "d" } ) {
+        s.iface.send_datagram( make_datagram( payload ), Address( "10.0.0.1", 0 ) );
+      }
+      test_should_be( s.out->frames.size(), size_t { 1 } ); // one ARP request
+      sent_payloads( *s.out );
+      test_should_be( s.iface.pending_stats().queued, uint64_t { 2 } );
+      test_should_be( s.iface.pending_stats().dropped_overflow, uint64_t { 2 } );
+      test_should_be( s.iface.pending_stats().packets_pending, uint64_t { 2 } );
+
+      s.iface.recv_frame( make_arp_reply( remote_eth, "10.0.0.1" ) );
+      test_should_be( ( sent_payloads( *s.out ) == vector<string> { "a", "b" } ), true );
+      test_should_be( s.iface.pending_stats().sent, uint64_t { 2 } );
+      test_should_be( s.iface.pending_stats().packets_pending, uint64_t { 0 } );
+      test_should_be( s.iface.pending_stats().bytes_pending, uint64_t { 0 } );
+    }
+
+    // per-neighbor packet limit, dropping the oldest
+    {
+      Setup s;
+      s.iface.set_pending_limits( { 2, 1 << 20, 1 << 20, 1 << 20, NetworkInterface::DropPolicy::DropOldest } );
+      for ( const auto* payload : { "a", "b", "c", "d" } ) {
+        s.iface.send_datagram( make_datagram( payload ), Address( "10.0.0.1", 0 ) );
+      }
+      test_should_be( s.iface.pending_stats().queued, uint64_t { 4 } );
+      test_should_be( s.iface.pending_stats().dropped_overflow, uint64_t { 2 } );
+      s.iface.recv_frame( make_arp_reply( remote_eth, "10.0.0.1" ) );
+      test_should_be( ( sent_payloads( *s.out ) == vector<string> { "c", "d" } ), true );
+    }
+
+    // dropping the oldest, a datagram that could never fit is dropped without evicting anything
+    {
+      Setup s;
+      s.iface.set_pending_limits( { 100, 50, 1 << 20, 70, NetworkInterface::DropPolicy::DropOldest } );
+      s.iface.send_datagram( make_datagram( "a" ), Address( "10.0.0.1", 0 ) );
+      s.iface.send_datagram( make_datagram( "b" ), Address( "10.0.0.1", 0 ) );
+      s.iface.send_datagram( make_datagram( string( 40, 'x' ) ), Address( "10.0.0.1", 0 ) ); // over 50 bytes
+      test_should_be( s.iface.pending_stats().packets_pending, uint64_t { 2 } );
+      test_should_be( s.iface.pending_stats().dropped_overflow, uint64_t { 1 } );
+
+      // the global limit stays exceeded even with this neighbor's queue empty
+      s.iface.send_datagram( make_datagram( "c" ), Address( "10.0.0.2", 0 ) );
+      s.iface.send_datagram( make_datagram( "0123456789" ), Address( "10.0.0.2", 0 ) );
+      test_should_be( s.iface.pending_stats().packets_pending, uint64_t { 3 } );
+      test_should_be( s.iface.pending_stats().dropped_overflow, uint64_t { 2 } );
+
+      s.iface.recv_frame( make_arp_reply( remote_eth, "10.0.0.1" ) );
+      test_should_be( ( sent_payloads( *s.out ) == vector<string> { "a", "b" } ), true );
+    }
+
+    // per-neighbor byte limit (each datagram is 20 bytes of header plus its payload)
+    {
+      Setup s;
+      s.iface.set_pending_limits( { 100, 50, 1 << 20, 1 << 20, NetworkInterface::DropPolicy::DropNewest } );
+      s.iface.send_datagram( make_datagram( "0123456789" ), Address( "10.0.0.1", 0 ) );
+      s.iface.send_datagram( make_datagram( "0123456789" ), Address( "10.0.0.1", 0 ) );
+      s.iface.send_datagram( make_datagram( "x" ), Address( "10.0.0.1", 0 ) );
+      test_should_be( s.iface.pending_stats().queued, uint64_t { 1 } );
+      test_should_be( s.iface.pending_stats().bytes_pending, uint64_t { 30 } );
+      test_should_be( s.iface.pending_stats().dropped_overflow, uint64_t { 2 } );
+    }
+
+    // global packet limit across neighbors
+    {
+      Setup s;
+      s.iface.set_pending_limits( { 100, 1 << 20, 3, 1 << 20, NetworkInterface::DropPolicy::DropNewest } );
+      s.iface.send_datagram( make_datagram( "a" ), Address( "10.0.0.1", 0 ) );
+      s.iface.send_datagram( make_datagram( "b" ), Address( "10.0.0.1", 0 ) );
+      s.iface.send_datagram( make_datagram( "c" ), Address( "10.0.0.2", 0 ) );
+      s.iface.send_datagram( make_datagram( "d" ), Address( "10.0.0.2", 0 ) );
+      test_should_be( s.iface.pending_stats().packets_pending, uint64_t { 3 } );
+      test_should_be( s.iface.pending_stats().dropped_overflow, uint64_t { 1 } );
+
+      // resolving one neighbor makes room for more
+      sent_payloads( *s.out );
+      s.iface.recv_frame( make_arp_reply( remote_eth, "10.0.0.1" ) );
+      test_should_be( ( sent_payloads( *s.out ) == vector<string> { "a", "b" } ), true );
+      s.iface.send_datagram( make_datagram( "e" ), Address( "10.0.0.2", 0 ) );
+      test_should_be( s.iface.pending_stats().packets_pending, uint64_t { 2 } );
+      s.iface.recv_frame( make_arp_reply( other_eth, "10.0.0.2" ) );
+      test_should_be( ( sent_payloads( *s.out ) == vector<string> { "c", "e" } ), true );
+    }
+
+    // datagrams for a next hop that never answers are dropped with its request
+    {
+      Setup s;
+      s.iface.send_datagram( make_datagram( "a" ), Address( "10.0.0.1", 0 ) );
+      s.iface.send_datagram( make_datagram( "b" ), Address( "10.0.0.1", 0 ) );
+      s.iface.tick( 4999 );
+      test_should_be( s.iface.pending_stats().packets_pending, uint64_t { 2 } );
+      s.iface.tick( 1 );
+      test_should_be( s.iface.pending_stats().packets_pending, uint64_t { 0 } );
+      test_should_be( s.iface.pending_stats().bytes_pending, uint64_t { 0 } );
+      test_should_be( s.iface.pending_stats().dropped_unresolved, uint64_t { 2 } );
+    }
+
+    // resolution latency histogram
+    {
+      Setup s;
+      s.iface.send_datagram( make_datagram( "a" ), Address( "10.0.0.1", 0 ) );
+      s.iface.send_datagram( make_datagram( "b" ), Address( "10.0.0.2", 0 ) );
+      s.iface.recv_frame( make_arp_reply( remote_eth, "10.0.0.1" ) ); // same millisecond
+      s.iface.tick( 3 );
+      s.iface.recv_frame( make_arp_reply( other_eth, "10.0.0.2" ) ); // 3 ms: bucket [2, 4)
+      s.iface.recv_frame( make_arp_reply( other_eth, "10.0.0.2" ) ); // already resolved: not counted
+
+      const auto& latency = s.iface.pending_stats().resolve_latency_ms;
+      test_should_be( latency.at( 0 ), uint64_t { 1 } );
+      test_should_be( latency.at( 2 ), uint64_t { 1 } );
+      uint64_t total = 0;
+      for ( const auto n : latency ) {
+        total += n;
+      }
+      test_should_be( total, uint64_t { 2 } );
+    }
+
+    // the datagrams released by an ARP reply leave in one batch, in order
+    {
+      auto out = make_shared<BatchCountingPort>();
+      NetworkInterface iface { "test", out, local_eth, Address( "4.3.2.1", 0 ) };
+      for ( const auto* payload : { "a", "b", "c" } ) {
+        iface.send_datagram( make_datagram( payload ), Address( "10.0.0.1", 0 ) );
+      }
+      test_should_be( out->batches.empty(), true );
+      sent_payloads( *out );
+      iface.recv_frame( make_arp_reply( remote_eth, "10.0.0.1" ) );
+      test_should_be( ( out->batches == vector<size_t> { 3 } ), true );
+      test_should_be( ( sent_payloads( *out ) == vector<string> { "a", "b", "c" } ), true );
+
+      // so do several datagrams to a resolved neighbor; a single one goes through transmit()
+      const vector<InternetDatagram> dgrams { make_datagram( "d" ), make_datagram( "e" ) };
+      iface.send_datagrams( dgrams, Address( "10.0.0.1", 0 ) );
+      iface.send_datagram( make_datagram( "f" ), Address( "10.0.0.1", 0 ) );
+      test_should_be( ( out->batches == vector<size_t> { 3, 2 } ), true );
+      test_should_be( ( sent_payloads( *out ) == vector<string> { "d", "e", "f" } ), true );
+    }
+  } catch ( const exception& e ) {
+    cerr << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
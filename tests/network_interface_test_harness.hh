@@ -49,16 +49,16 @@ struct SendDatagram : public Action<InterfaceAndOutput>
   SendDatagram( InternetDatagram d, Address n ) : dgram( std::move( d ) ), next_hop( n ) {}
 };
 
-inline std::string concat( const std::vector<std::string>& buffers )
+inline std::string concat( const BufferList& buffers )
 {
-  return std::accumulate( buffers.begin(), buffers.end(), std::string {} );
+  return buffers.concatenate();
 }
 
 template<class T>
 bool equal( const T& t1, const T& t2 )
 {
-  const std::vector<std::string> t1s = serialize( t1 );
-  const std::vector<std::string> t2s = serialize( t2 );
+  const BufferList t1s = serialize( t1 );
+  const BufferList t2s = serialize( t2 );
 
   return concat( t1s ) == concat( t2s );
 }
@@ -0,0 +1,125 @@
+#include "random.hh"
+#include "reassembler_test_harness.hh"
+
+#include <algorithm>
+#include <cstdint>
+#include <exception>
+#include <iostream>
+#include <tuple>
+#include <vector>
+
+using namespace std;
+
+static constexpr auto IN_PLACE = Reassembler::Storage::InPlace;
+
+static constexpr size_t NREPS = 32;
+static constexpr size_t NSEGS = 128;
+static constexpr size_t MAX_SEG_LEN = 2048;
+
+int main()
+{
+  try {
+    {
+      ReassemblerTestHarness test { "in-place holes", 65000, IN_PLACE };
+
+      test.execute( Insert { "b", 1 }.is_last() );
+
+      test.execute( BytesPushed( 0 ) );
+      test.execute( BytesPending( 1 ) );
+      test.execute( ReadAll( "" ) );
+      test.execute( IsFinished { false } );
+
+      test.execute( Insert { "a", 0 } );
+
+      test.execute( BytesPushed( 2 ) );
+      test.execute( BytesPending( 0 ) );
+      test.execute( ReadAll( "ab" ) );
+      test.execute( IsFinished { true } );
+    }
+
+    {
+      ReassemblerTestHarness test { "in-place overlapping", 1000, IN_PLACE };
+
+      test.execute( Insert { "cd", 2 } );
+      test.execute( Insert { "gh", 6 } );
+      test.execute( Insert { "cdef", 2 } );
+      test.execute( BytesPending( 6 ) );
+
+      test.execute( Insert { "abc", 0 } );
+
+      test.execute( BytesPushed( 8 ) );
+      test.execute( BytesPending( 0 ) );
+      test.execute( ReadAll( "abcdefgh" ) );
+    }
+
+    {
+      ReassemblerTestHarness test { "in-place capacity", 8, IN_PLACE };
+
+      test.execute( Insert { "ab", 0 } );
+      test.execute( Insert { "ijkl", 8 } );
+      test.execute( Insert { "efghij", 4 } );
+
+      test.execute( BytesPushed( 2 ) );
+      test.execute( BytesPending( 4 ) );
+      test.execute( ReadAll( "ab" ) );
+
+      test.execute( Insert { "cd", 2 } );
+
+      test.execute( BytesPushed( 8 ) );
+      test.execute( BytesPending( 0 ) );
+      test.execute( Insert { "ijkl", 8 }.is_last() );
+      test.execute( BytesPushed( 10 ) );
+      test.execute( IsFinished { false } );
+      test.execute( ReadAll( "cdefghij" ) );
+
+      test.execute( Insert { "ijkl", 8 }.is_last() );
+      test.execute( ReadAll( "kl" ) );
+      test.execute( IsFinished { true } );
+    }
+
+    {
+      // writes that wrap around the end of the output stream's ring
+      ReassemblerTestHarness test { "in-place wraparound", 8, IN_PLACE };
+
+      test.execute( Insert { "abcdef", 0 } );
+      test.execute( ReadAll( "abcdef" ) );
+
+      test.execute( Insert { "jklm", 9 } );
+      test.execute( Insert { "ghi", 6 } );
+
+      test.execute( BytesPushed( 13 ) );
+      test.execute( ReadAll( "ghijklm" ) );
+    }
+
+    // overlapping segments arriving in random order
+    auto rd = get_random_engine();
+    for ( unsigned rep_no = 0; rep_no < NREPS; ++rep_no ) {
+      ReassemblerTestHarness sr { "in-place win test " + to_string( rep_no ), NSEGS * MAX_SEG_LEN, IN_PLACE };
+
+      vector<tuple<size_t, size_t>> seq_size;
+      size_t offset = 0;
+      for ( unsigned i = 0; i < NSEGS; ++i ) {
+        const size_t size = 1 + ( rd() % ( MAX_SEG_LEN - 1 ) );
+        const size_t offs = min( offset, 1 + ( static_cast<size_t>( rd() ) % 1023 ) );
+        seq_size.emplace_back( offset - offs, size + offs );
+        offset += size;
+      }
+      shuffle( seq_size.begin(), seq_size.end(), rd );
+
+      string d( offset, 0 );
+      generate( d.begin(), d.end(), [&] { return rd(); } );
+
+      for ( auto [off, sz] : seq_size ) {
+        sr.execute( Insert { d.substr( off, sz ), off }.is_last( off + sz == offset ) );
+      }
+
+      sr.execute( ReadAll { d } );
+      sr.execute( IsFinished { true } );
+    }
+  } catch ( const exception& e ) {
+    cerr << "Exception: " << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -9,13 +9,20 @@
 #include <queue>
 #include <random>
 #include <tuple>
+#include <vector>
 
 using namespace std;
 using namespace std::chrono;
 
-void speed_test( const size_t num_chunks,   // NOLINT(bugprone-easily-swappable-parameters)
-                 const size_t capacity,     // NOLINT(bugprone-easily-swappable-parameters)
-                 const size_t random_seed ) // NOLINT(bugprone-easily-swappable-parameters)
+static string storage_name( Reassembler::Storage storage )
+{
+  return storage == Reassembler::Storage::InPlace ? "in-place" : "chunks";
+}
+
+void speed_test( const size_t num_chunks,  // NOLINT(bugprone-easily-swappable-parameters)
+                 const size_t capacity,    // NOLINT(bugprone-easily-swappable-parameters)
+                 const size_t random_seed, // NOLINT(bugprone-easily-swappable-parameters)
+                 const Reassembler::Storage storage )
 {
   // Generate the data to be written
   const string data = [&] {
@@ -36,7 +43,7 @@ void speed_test( const size_t num_chunks,   // NOLINT(bugprone-easily-swappable-
     split_data.emplace( i + 1, data.substr( i + 1, capacity * 2 ), i + 1 + capacity * 2 >= data.size() );
   }
 
-  Reassembler reassembler { ByteStream { capacity } };
+  Reassembler reassembler { ByteStream { capacity }, storage };
 
   string output_data;
   output_data.reserve( data.size() );
@@ -71,20 +78,92 @@ void speed_test( const size_t num_chunks,   // NOLINT(bugprone-easily-swappable-
   fstream debug_output;
   debug_output.open( "/dev/tty" );
 
-  cout << "Reassembler to ByteStream with capacity=" << capacity << " reached " << fixed << setprecision( 2 )
-       << gigabits_per_second << " Gbit/s.\n";
+  cout << "Reassembler (" << storage_name( storage ) << ") to ByteStream with capacity=" << capacity << " reached "
+       << fixed << setprecision( 2 ) << gigabits_per_second << " Gbit/s.\n";
 
-  debug_output << "             Reassembler throughput: " << fixed << setprecision( 2 ) << gigabits_per_second
-               << " Gbit/s\n";
+  debug_output << "             Reassembler throughput (" << storage_name( storage ) << "): " << fixed
+               << setprecision( 2 ) << gigabits_per_second << " Gbit/s\n";
 
   if ( gigabits_per_second < 0.1 ) {
     throw runtime_error( "Reassembler did not meet minimum speed of 0.1 Gbit/s." );
   }
 }
 
+// Many small chunks arriving in random order, so that tens of thousands of chunks are pending at once
+void reorder_speed_test( const size_t num_chunks,  // NOLINT(bugprone-easily-swappable-parameters)
+                         const size_t chunk_size,  // NOLINT(bugprone-easily-swappable-parameters)
+                         const size_t random_seed, // NOLINT(bugprone-easily-swappable-parameters)
+                         const Reassembler::Storage storage )
+{
+  default_random_engine rd { random_seed };
+
+  // Generate the data to be written
+  const string data = [&] {
+    uniform_int_distribution<char> ud;
+    string ret;
+    for ( size_t i = 0; i < num_chunks * chunk_size; ++i ) {
+      ret += ud( rd );
+    }
+    return ret;
+  }();
+
+  // Split the data into (slightly overlapping) chunks and shuffle them
+  vector<tuple<uint64_t, string, bool>> split_data;
+  split_data.reserve( num_chunks );
+  for ( size_t i = 0; i < data.size(); i += chunk_size ) {
+    split_data.emplace_back( i, data.substr( i, chunk_size + 1 ), i + chunk_size + 1 >= data.size() );
+  }
+  shuffle( split_data.begin(), split_data.end(), rd );
+
+  Reassembler reassembler { ByteStream { data.size() }, storage };
+
+  string output_data;
+  output_data.reserve( data.size() );
+
+  const auto start_time = steady_clock::now();
+  for ( auto& [index, chunk, is_last] : split_data ) {
+    reassembler.insert( index, move( chunk ), is_last );
+
+    while ( reassembler.reader().bytes_buffered() ) {
+      output_data += reassembler.reader().peek();
+      reassembler.reader().pop( output_data.size() - reassembler.reader().bytes_popped() );
+    }
+  }
+
+  const auto stop_time = steady_clock::now();
+
+  if ( not reassembler.reader().is_finished() ) {
+    throw runtime_error( "Reassembler did not close ByteStream when finished" );
+  }
+
+  if ( data != output_data ) {
+    throw runtime_error( "Mismatch between data written and read" );
+  }
+
+  auto test_duration = duration_cast<duration<double>>( stop_time - start_time );
+  auto chunks_per_second = static_cast<double>( num_chunks ) / test_duration.count();
+
+  fstream debug_output;
+  debug_output.open( "/dev/tty" );
+
+  cout << "Reassembler (" << storage_name( storage ) << ") with " << num_chunks << " reordered chunks of "
+       << chunk_size << " bytes reached " << fixed << setprecision( 2 ) << chunks_per_second / 1e6
+       << " million chunks/s.\n";
+
+  debug_output << "   Reassembler reordered throughput (" << storage_name( storage ) << "): " << fixed
+               << setprecision( 2 ) << chunks_per_second / 1e6 << " million chunks/s\n";
+
+  if ( chunks_per_second < 1e5 ) {
+    throw runtime_error( "Reassembler did not meet minimum speed of 100k reordered chunks/s." );
+  }
+}
+
 void program_body()
 {
-  speed_test( 10000, 1500, 1370 );
+  speed_test( 10000, 1500, 1370, Reassembler::Storage::Chunks );
+  speed_test( 10000, 1500, 1370, Reassembler::Storage::InPlace );
+  reorder_speed_test( 200000, 100, 1371, Reassembler::Storage::Chunks );
+  reorder_speed_test( 200000, 100, 1371, Reassembler::Storage::InPlace );
 }
 
 int main()
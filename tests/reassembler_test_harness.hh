@@ -38,6 +38,13 @@ public:
                    { Reassembler { ByteStream { capacity } } } )
   {}
 
+  ReassemblerTestHarness( std::string test_name, uint64_t capacity, Reassembler::Storage storage )
+    : TestHarness( move( test_name ),
+                   "capacity=" + std::to_string( capacity )
+                     + ( storage == Reassembler::Storage::InPlace ? ", in-place storage" : ", chunk storage" ),
+                   { Reassembler { ByteStream { capacity }, storage } } )
+  {}
+
   template<std::derived_from<TestStep<ByteStream>> T>
   void execute( const T& test )
   {
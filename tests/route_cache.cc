@@ -0,0 +1,143 @@
+#include "random.hh"
+#include "route_cache.hh"
+#include "router.hh"
+#include "test_should_be.hh"
+
+#include <cstdint>
+#include <exception>
+#include <iostream>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+#include <vector>
+
+using namespace std;
+
+class NullPort : public NetworkInterface::OutputPort
+{
+public:
+  void transmit( const NetworkInterface& sender [[maybe_unused]],
+                 const EthernetFrame& frame [[maybe_unused]] ) override
+  {}
+};
+
+static InternetDatagram datagram_to( uint32_t dst )
+{
+  InternetDatagram dgram;
+  dgram.header.src = Address { "1.2.3.4" }.ipv4_numeric();
+  dgram.header.dst = dst;
+  dgram.header.compute_checksum();
+  return dgram;
+}
+
+int main()
+{
+  try {
+    RouteTable table;
+    table.add( 0x0a000000, 8, {}, 1 );
+    table.add( 0x0a0a0000, 16, {}, 2 );
+    const RouteTable::Route* route_a = table.lookup( 0x0a000001 );
+    const RouteTable::Route* route_b = table.lookup( 0x0a0a0001 );
+
+    // hits, misses and negative entries
+    {
+      RouteCache cache { 1 };
+      test_should_be( cache.capacity(), RouteCache::WAYS );
+      test_should_be( cache.find( 0x0a000001 ).has_value(), false );
+      cache.insert( 0x0a000001, route_a );
+      cache.insert( 0x0b000001, nullptr );
+      test_should_be( cache.find( 0x0a000001 ).value() == route_a, true );
+      test_should_be( cache.find( 0x0b000001 ).value() == nullptr, true );
+      test_should_be( cache.stats().hits, uint64_t { 2 } );
+      test_should_be( cache.stats().misses, uint64_t { 1 } );
+
+      // inserting an address that is already cached replaces its entry
+      cache.insert( 0x0a000001, route_b );
+      test_should_be( cache.find( 0x0a000001 ).value() == route_b, true );
+    }
+
+    // least recently used entries are evicted first
+    {
+      RouteCache cache { 1 };
+      for ( uint32_t i = 0; i < RouteCache::WAYS; ++i ) {
+        cache.insert( i, route_a );
+      }
+      test_should_be( cache.find( 0 ).has_value(), true ); // 0 is now the most recently used
+      cache.insert( 100, route_b );                         // evicts 1
+      test_should_be( cache.find( 1 ).has_value(), false );
+      test_should_be( cache.find( 0 ).has_value(), true );
+      test_should_be( cache.find( 100 ).has_value(), true );
+    }
+
+    // clear() forgets everything
+    {
+      RouteCache cache;
+      for ( uint32_t i = 0; i < 100; ++i ) {
+        cache.insert( i, route_a );
+      }
+      cache.clear();
+      for ( uint32_t i = 0; i < 100; ++i ) {
+        test_should_be( cache.find( i ).has_value(), false );
+      }
+    }
+
+    // the cache never returns a stale route, compared against the table itself
+    {
+      auto rd = get_random_engine();
+      RouteCache cache { 4 };
+      for ( size_t i = 0; i < 100000; ++i ) {
+        const uint32_t address = 0x0a000000 | ( rd() % 64 ) << 12;
+        const auto cached = cache.find( address );
+        if ( cached ) {
+          test_should_be( *cached == table.lookup( address ), true );
+        } else {
+          cache.insert( address, table.lookup( address ) );
+        }
+      }
+      test_should_be( cache.stats().hits > 0, true );
+    }
+
+    // invalid sizes
+    {
+      bool threw = false;
+      try {
+        RouteCache cache { 3 };
+      } catch ( const runtime_error& ) {
+        threw = true;
+      }
+      test_should_be( threw, true );
+    }
+
+    // the Router counts hits and misses, and adding a route invalidates the cache
+    {
+      Router router;
+      auto port = make_shared<NullPort>();
+      router.add_interface( make_shared<NetworkInterface>(
+        "eth0", port, EthernetAddress { 2, 0, 0, 0, 0, 1 }, Address { "10.0.0.1" } ) );
+      router.add_interface( make_shared<NetworkInterface>(
+        "eth1", port, EthernetAddress { 2, 0, 0, 0, 0, 2 }, Address { "172.16.0.1" } ) );
+      router.add_route( Address { "10.0.0.0" }.ipv4_numeric(), 8, {}, 0 );
+
+      const uint32_t dst = Address { "172.16.0.5" }.ipv4_numeric();
+      router.interface( 0 )->datagrams_received().push( datagram_to( dst ) );
+      router.route();
+      test_should_be( router.route_cache_stats().misses, uint64_t { 1 } );
+
+      router.interface( 0 )->datagrams_received().push( datagram_to( dst ) );
+      router.interface( 0 )->datagrams_received().push( datagram_to( dst ) );
+      router.route();
+      test_should_be( router.route_cache_stats().hits, uint64_t { 2 } );
+
+      router.add_route( Address { "172.16.0.0" }.ipv4_numeric(), 12, {}, 1 );
+      router.interface( 0 )->datagrams_received().push( datagram_to( dst ) );
+      router.route();
+      test_should_be( router.route_cache_stats().hits, uint64_t { 2 } );
+      test_should_be( router.route_cache_stats().misses, uint64_t { 2 } );
+    }
+  } catch ( const exception& e ) {
+    cerr << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
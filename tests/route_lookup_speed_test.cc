@@ -0,0 +1,167 @@
+#include "random.hh"
+#include "route_cache.hh"
+#include "route_table.hh"
+
+#include <chrono>
+#include <cstddef>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace std;
+using namespace std::chrono;
+
+// Lookups in a full-Internet-sized forwarding table must not depend on the number of routes.
+
+static constexpr size_t NUM_ROUTES = 500000;
+static constexpr size_t NUM_LOOKUPS = 1 << 24;
+static constexpr size_t BATCH_SIZE = 64;
+static constexpr double MIN_LOOKUPS_PER_SEC = 2e7;
+
+struct Prefix
+{
+  uint32_t prefix;
+  uint8_t prefix_length;
+};
+
+// Uniformly random prefixes of /16 to /32
+static vector<Prefix> random_prefixes( default_random_engine& rd )
+{
+  vector<Prefix> ret;
+  for ( size_t i = 0; i < NUM_ROUTES; ++i ) {
+    ret.push_back( { static_cast<uint32_t>( rd() ), static_cast<uint8_t>( 16 + rd() % 17 ) } );
+  }
+  return ret;
+}
+
+// Roughly the shape of a BGP table: over half /24s, most of the rest /16 to /23, a few host routes and a
+// default route
+static vector<Prefix> realistic_prefixes( default_random_engine& rd )
+{
+  vector<Prefix> ret { { 0, 0 } };
+  while ( ret.size() < NUM_ROUTES ) {
+    const size_t bucket = rd() % 100;
+    uint8_t prefix_length {};
+    if ( bucket < 60 ) {
+      prefix_length = 24;
+    } else if ( bucket < 75 ) {
+      prefix_length = 22 + rd() % 2;
+    } else if ( bucket < 97 ) {
+      prefix_length = 16 + rd() % 6;
+    } else if ( bucket < 99 ) {
+      prefix_length = 8 + rd() % 8;
+    } else {
+      prefix_length = 25 + rd() % 8;
+    }
+    // keep to the unicast space
+    ret.push_back( { ( static_cast<uint32_t>( rd() ) % 0xdf000000 ) + 0x01000000, prefix_length } );
+  }
+  return ret;
+}
+
+void benchmark( const string& name, const vector<Prefix>& prefixes, default_random_engine& rd )
+{
+  RouteTable table;
+  const auto build_start = steady_clock::now();
+  for ( size_t i = 0; i < prefixes.size(); ++i ) {
+    table.add( prefixes[i].prefix, prefixes[i].prefix_length, {}, i % 64 );
+  }
+  const auto build_stop = steady_clock::now();
+
+  // half the lookups go to addresses inside the table's prefixes, half are uniformly random
+  vector<uint32_t> addresses;
+  for ( size_t i = 0; i < 1 << 20; ++i ) {
+    addresses.push_back( i % 2 ? static_cast<uint32_t>( rd() )
+                               : prefixes[rd() % prefixes.size()].prefix | ( rd() & 0xff ) );
+  }
+
+  size_t found = 0;
+  const auto start_time = steady_clock::now();
+  for ( size_t i = 0; i < NUM_LOOKUPS; ++i ) {
+    const RouteTable::Route* route = table.lookup( addresses[i & ( addresses.size() - 1 )] );
+    found += route ? route->interface_num : 0;
+  }
+  const auto stop_time = steady_clock::now();
+
+  // the same lookups, a batch at a time
+  size_t batch_found = 0;
+  vector<const RouteTable::Route*> routes( BATCH_SIZE );
+  const auto batch_start_time = steady_clock::now();
+  for ( size_t i = 0; i < NUM_LOOKUPS; i += BATCH_SIZE ) {
+    table.lookup( span { addresses }.subspan( i & ( addresses.size() - 1 ), BATCH_SIZE ), routes );
+    for ( const auto* route : routes ) {
+      batch_found += route ? route->interface_num : 0;
+    }
+  }
+  const auto batch_stop_time = steady_clock::now();
+
+  // a few heavy flows (90% of lookups go to 64 destinations), through the route cache
+  vector<uint32_t> heavy_addresses;
+  for ( size_t i = 0; i < 1 << 20; ++i ) {
+    heavy_addresses.push_back( rd() % 10 ? addresses[rd() % 64] : addresses[rd() % addresses.size()] );
+  }
+  RouteCache cache;
+  size_t cached_found = 0;
+  const auto cache_start_time = steady_clock::now();
+  for ( size_t i = 0; i < NUM_LOOKUPS; ++i ) {
+    const uint32_t address = heavy_addresses[i & ( heavy_addresses.size() - 1 )];
+    const auto cached = cache.find( address );
+    const RouteTable::Route* route = cached ? *cached : table.lookup( address );
+    if ( not cached ) {
+      cache.insert( address, route );
+    }
+    cached_found += route ? route->interface_num : 0;
+  }
+  const auto cache_stop_time = steady_clock::now();
+
+  const double build_ms = duration_cast<duration<double, milli>>( build_stop - build_start ).count();
+  const double lookups_per_sec = NUM_LOOKUPS / duration_cast<duration<double>>( stop_time - start_time ).count();
+  const double batch_lookups_per_sec
+    = NUM_LOOKUPS / duration_cast<duration<double>>( batch_stop_time - batch_start_time ).count();
+  const double cached_lookups_per_sec
+    = NUM_LOOKUPS / duration_cast<duration<double>>( cache_stop_time - cache_start_time ).count();
+  const double hit_rate = static_cast<double>( cache.stats().hits ) / NUM_LOOKUPS;
+
+  fstream debug_output;
+  debug_output.open( "/dev/tty" );
+
+  cout << "Route lookup (" << name << ", " << prefixes.size() << " routes) reached " << fixed << setprecision( 1 )
+       << lookups_per_sec / 1e6 << " million lookups/s, " << batch_lookups_per_sec / 1e6 << " million/s in batches of "
+       << BATCH_SIZE << " (table built in " << build_ms << " ms).\n"
+       << "Route lookup (" << name << ", heavy flows) reached " << cached_lookups_per_sec / 1e6
+       << " million lookups/s through the route cache (" << hit_rate * 100 << "% hits).\n";
+  debug_output << "   " << name << " route lookups: " << fixed << setprecision( 1 ) << lookups_per_sec / 1e6
+               << " M/s, batched " << batch_lookups_per_sec / 1e6 << " M/s, heavy flows cached " << cached_lookups_per_sec / 1e6
+               << " M/s [checksum " << found + cached_found << "]\n";
+
+  if ( found != batch_found ) {
+    throw runtime_error( "Batched lookups disagree with single lookups." );
+  }
+  if ( lookups_per_sec < MIN_LOOKUPS_PER_SEC or batch_lookups_per_sec < MIN_LOOKUPS_PER_SEC
+       or cached_lookups_per_sec < MIN_LOOKUPS_PER_SEC ) {
+    throw runtime_error( "Route lookup is too slow." );
+  }
+}
+
+void program_body()
+{
+  auto rd = get_random_engine();
+  benchmark( "random", random_prefixes( rd ), rd );
+  benchmark( "realistic", realistic_prefixes( rd ), rd );
+}
+
+int main()
+{
+  try {
+    program_body();
+  } catch ( const exception& e ) {
+    cerr << "Exception: " << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
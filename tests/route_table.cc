@@ -0,0 +1,148 @@
+#include "random.hh"
+#include "route_table.hh"
+#include "test_should_be.hh"
+
+#include <cstdint>
+#include <exception>
+#include <iostream>
+#include <optional>
+#include <stdexcept>
+#include <vector>
+
+using namespace std;
+
+// The obvious linear-scan longest-prefix match, as an independent reference
+struct ReferenceTable
+{
+  struct Entry
+  {
+    uint32_t prefix;
+    uint8_t prefix_length;
+    size_t interface_num;
+  };
+  vector<Entry> entries {};
+
+  optional<size_t> lookup( uint32_t address ) const
+  {
+    optional<size_t> ret;
+    int best_length = -1;
+    for ( const auto& e : entries ) {
+      const uint32_t mask = e.prefix_length ? ~uint32_t { 0 } << ( 32 - e.prefix_length ) : 0;
+      // later routes for the same prefix replace earlier ones
+      if ( ( address & mask ) == ( e.prefix & mask ) and e.prefix_length >= best_length ) {
+        best_length = e.prefix_length;
+        ret = e.interface_num;
+      }
+    }
+    return ret;
+  }
+};
+
+static void check( const RouteTable& table, const ReferenceTable& reference, uint32_t address )
+{
+  const RouteTable::Route* route = table.lookup( address );
+  const optional<size_t> expected = reference.lookup( address );
+  if ( route == nullptr ) {
+    test_should_be( expected.has_value(), false );
+  } else {
+    test_should_be( expected.has_value(), true );
+    test_should_be( route->interface_num, expected.value() );
+  }
+}
+
+int main()
+{
+  try {
+    auto rd = get_random_engine();
+
+    // basics
+    {
+      RouteTable table;
+      test_should_be( table.lookup( 0x0a000001 ) == nullptr, true );
+
+      table.add( 0x0a000000, 8, {}, 1 );
+      table.add( 0x0a0a0a00, 24, Address { "192.168.0.1" }, 2 );
+      table.add( 0x0a0a0a80, 25, {}, 3 );
+      table.add( 0x0a0a0a81, 32, {}, 4 );
+
+      test_should_be( table.lookup( 0x0b000001 ) == nullptr, true );
+      test_should_be( table.lookup( 0x0a000001 )->interface_num, size_t { 1 } );
+      test_should_be( table.lookup( 0x0a0a0a01 )->interface_num, size_t { 2 } );
+      test_should_be( table.lookup( 0x0a0a0a01 )->next_hop->ipv4_numeric(), Address { "192.168.0.1" }.ipv4_numeric() );
+      test_should_be( table.lookup( 0x0a0a0a80 )->interface_num, size_t { 3 } );
+      test_should_be( table.lookup( 0x0a0a0a81 )->interface_num, size_t { 4 } );
+      test_should_be( table.lookup( 0x0a0a0aff )->interface_num, size_t { 3 } );
+
+      // shorter routes added later must not override longer ones
+      table.add( 0, 0, {}, 5 );
+      table.add( 0x0a0a0000, 16, {}, 6 );
+      test_should_be( table.lookup( 0x0b000001 )->interface_num, size_t { 5 } );
+      test_should_be( table.lookup( 0x0a0a0b01 )->interface_num, size_t { 6 } );
+      test_should_be( table.lookup( 0x0a0a0a01 )->interface_num, size_t { 2 } );
+      test_should_be( table.lookup( 0x0a0a0a81 )->interface_num, size_t { 4 } );
+
+      // host bits beyond the prefix length are ignored, and the same prefix replaces the earlier route
+      table.add( 0x0a0a0aff, 24, {}, 7 );
+      test_should_be( table.lookup( 0x0a0a0a01 )->interface_num, size_t { 7 } );
+      test_should_be( table.lookup( 0x0a0a0a81 )->interface_num, size_t { 4 } );
+    }
+
+    // invalid prefix length
+    {
+      RouteTable table;
+      bool threw = false;
+      try {
+        table.add( 0, 33, {}, 0 );
+      } catch ( const runtime_error& ) {
+        threw = true;
+      }
+      test_should_be( threw, true );
+    }
+
+    // random tables, compared against the linear scan
+    for ( size_t rep = 0; rep < 4; ++rep ) {
+      RouteTable table;
+      ReferenceTable reference;
+
+      // cluster the prefixes under a few /8s so that they nest and overlap
+      vector<uint32_t> bases;
+      for ( size_t i = 0; i < 4; ++i ) {
+        bases.push_back( static_cast<uint32_t>( rd() ) & 0xff000000 );
+      }
+      const auto random_address = [&] { return bases[rd() % bases.size()] | ( rd() & 0x00ffffff ); };
+
+      for ( size_t i = 0; i < 300; ++i ) {
+        const uint32_t prefix = random_address();
+        const auto prefix_length = static_cast<uint8_t>( i % 100 == 0 ? rd() % 9 : 8 + rd() % 25 );
+        const size_t interface_num = rd() % 16;
+        table.add( prefix, prefix_length, {}, interface_num );
+        reference.entries.push_back( { prefix, prefix_length, interface_num } );
+
+        for ( size_t j = 0; j < 20; ++j ) {
+          check( table, reference, random_address() );
+          check( table, reference, static_cast<uint32_t>( rd() ) );
+        }
+      }
+      for ( const auto& e : reference.entries ) {
+        check( table, reference, e.prefix );
+        check( table, reference, e.prefix | ( e.prefix_length < 32 ? 1 : 0 ) );
+      }
+
+      // batched lookups agree with one-at-a-time lookups
+      vector<uint32_t> addresses;
+      for ( size_t i = 0; i < 100; ++i ) {
+        addresses.push_back( i % 2 ? random_address() : static_cast<uint32_t>( rd() ) );
+      }
+      vector<const RouteTable::Route*> routes( addresses.size() );
+      table.lookup( addresses, routes );
+      for ( size_t i = 0; i < addresses.size(); ++i ) {
+        test_should_be( routes[i] == table.lookup( addresses[i] ), true );
+      }
+    }
+  } catch ( const exception& e ) {
+    cerr << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -99,8 +99,8 @@ public:
     InternetDatagram dgram;
     dgram.header.src = _my_address.ipv4_numeric();
     dgram.header.dst = destination.ipv4_numeric();
-    dgram.payload.emplace_back( string { "Cardinal " + to_string( random_device()() % 1000 ) } );
-    dgram.header.len = static_cast<uint64_t>( dgram.header.hlen ) * 4 + dgram.payload.back().size();
+    dgram.payload.append( string { "Cardinal " + to_string( random_device()() % 1000 ) } );
+    dgram.header.len = static_cast<uint64_t>( dgram.header.hlen ) * 4 + dgram.payload.size();
     dgram.header.ttl = ttl;
     dgram.header.compute_checksum();
 
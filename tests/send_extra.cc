@@ -566,6 +566,28 @@ int main()
       test.execute( HasError { true } );
     }
 
+    // An ackno that arrives with RST must not retire bytes the errored stream can no longer release
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.isn = isn;
+      cfg.rt_timeout = 10;
+
+      TCPSenderTestHarness test { "RST with ackno -> retransmission keeps its payload", cfg };
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_no_flags().with_syn( true ).with_seqno( isn ) );
+      test.execute( AckReceived { Wrap32 { isn + 1 } }.with_win( 1000 ) );
+      test.execute( Push { "abc" } );
+      test.execute( ExpectMessage {}.with_no_flags().with_data( "abc" ).with_seqno( isn + 1 ) );
+      test.execute( Push { "def" } );
+      test.execute( ExpectMessage {}.with_no_flags().with_data( "def" ).with_seqno( isn + 4 ) );
+      test.execute( Receive { TCPReceiverMessage { Wrap32 { isn + 4 }, 1000, true } }.without_push() );
+      test.execute( HasError { true } );
+      test.execute( ExpectSeqnosInFlight { 6 } );
+      test.execute( Tick { 10 } );
+      test.execute( ExpectMessage {}.with_data( "abc" ).with_seqno( isn + 1 ) );
+    }
+
     // Newly added test: check RTO timer on invalid ackno
     {
       TCPConfig cfg;
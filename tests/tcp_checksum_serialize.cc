@@ -0,0 +1,75 @@
+#include "buffer.hh"
+#include "parser.hh"
+#include "random.hh"
+#include "tcp_segment.hh"
+#include "test_should_be.hh"
+
+#include <cstdint>
+#include <exception>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+using namespace std;
+
+static TCPSegment random_segment( default_random_engine& rd )
+{
+  TCPSegment seg;
+  seg.udinfo.src_port = rd();
+  seg.udinfo.dst_port = rd();
+  seg.udinfo.cksum = rd(); // stale value, should be overwritten
+  seg.message.sender.seqno = Wrap32 { static_cast<uint32_t>( rd() ) };
+  seg.message.sender.SYN = rd() % 2;
+  seg.message.sender.FIN = rd() % 2;
+  if ( rd() % 2 ) {
+    seg.message.receiver.ackno = Wrap32 { static_cast<uint32_t>( rd() ) };
+  }
+  seg.message.receiver.window_size = rd();
+
+  string payload( rd() % 2000, 0 );
+  for ( auto& ch : payload ) {
+    ch = static_cast<char>( rd() );
+  }
+  seg.message.sender.payload = std::move( payload );
+  return seg;
+}
+
+int main()
+{
+  try {
+    auto rd = get_random_engine();
+    BufferArena arena { 4096 };
+
+    for ( size_t rep = 0; rep < 10000; ++rep ) {
+      const uint32_t pseudo_checksum = rd() & 0x3ffff;
+      TCPSegment seg = random_segment( rd );
+
+      // the two-pass way
+      TCPSegment expected = seg;
+      expected.compute_checksum( pseudo_checksum );
+      const string expected_bytes = serialize( expected ).concatenate();
+
+      // the single-pass way, with and without an arena
+      for ( const bool use_arena : { false, true } ) {
+        TCPSegment actual = seg;
+        Serializer serializer = use_arena ? Serializer { arena } : Serializer {};
+        actual.serialize_with_checksum( serializer, pseudo_checksum );
+        const BufferList bytes = serializer.finish();
+
+        test_should_be( actual.udinfo.cksum, expected.udinfo.cksum );
+        if ( bytes.concatenate() != expected_bytes ) {
+          throw runtime_error( "single-pass serialization differs from compute_checksum() + serialize()" );
+        }
+
+        TCPSegment parsed;
+        test_should_be( parse( parsed, bytes, pseudo_checksum ), true );
+        test_should_be( parsed.udinfo.cksum, expected.udinfo.cksum );
+      }
+    }
+  } catch ( const exception& e ) {
+    cerr << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,98 @@
+#include "random.hh"
+#include "test_should_be.hh"
+#include "timer_wheel.hh"
+
+#include <algorithm>
+#include <cstdint>
+#include <exception>
+#include <iostream>
+#include <map>
+#include <vector>
+
+using namespace std;
+
+int main()
+{
+  try {
+    auto rd = get_random_engine();
+
+    // basic expiry, on the exact millisecond
+    {
+      TimerWheel wheel;
+      vector<uint32_t> expired;
+      const auto expire = [&]( uint32_t id, uint32_t ) { expired.push_back( id ); };
+
+      wheel.schedule( 5000, 1, 0 );
+      wheel.schedule( 30000, 2, 0 );
+      wheel.schedule( 0, 3, 0 ); // already due
+      test_should_be( wheel.size(), size_t { 3 } );
+
+      wheel.advance( 0, expire );
+      test_should_be( expired == vector<uint32_t> { 3 }, true );
+      wheel.advance( 4999, expire );
+      test_should_be( expired.size(), size_t { 1 } );
+      wheel.advance( 5000, expire );
+      test_should_be( ( expired == vector<uint32_t> { 3, 1 } ), true );
+      wheel.advance( 29999, expire );
+      test_should_be( expired.size(), size_t { 2 } );
+      wheel.advance( 1000000, expire );
+      test_should_be( ( expired == vector<uint32_t> { 3, 1, 2 } ), true );
+      test_should_be( wheel.size(), size_t { 0 } );
+      test_should_be( wheel.now(), uint64_t { 1000000 } );
+    }
+
+    // timers scheduled from an expiry callback
+    {
+      TimerWheel wheel;
+      size_t fired = 0;
+      wheel.schedule( 10, 0, 0 );
+      wheel.advance( 100, [&]( uint32_t, uint32_t cookie ) {
+        ++fired;
+        if ( cookie < 5 ) {
+          wheel.schedule( wheel.now() + 10, 0, cookie + 1 );
+        }
+      } );
+      test_should_be( fired, size_t { 6 } );
+      test_should_be( wheel.size(), size_t { 0 } );
+    }
+
+    // random timers (including ones beyond the top level), compared against an ordered multimap
+    for ( size_t rep = 0; rep < 20; ++rep ) {
+      TimerWheel wheel;
+      multimap<uint64_t, uint32_t> reference;
+      uint32_t next_id = 0;
+
+      for ( size_t step = 0; step < 2000; ++step ) {
+        const size_t num_new = rd() % 4;
+        for ( size_t i = 0; i < num_new; ++i ) {
+          const uint64_t range = rd() % 4 == 0 ? uint64_t { 1 } << 26 : rd() % 2 ? 100000 : 100;
+          const uint64_t deadline = wheel.now() + rd() % range;
+          wheel.schedule( deadline, next_id, 0 );
+          reference.emplace( deadline, next_id );
+          ++next_id;
+        }
+
+        const uint64_t range = rd() % 8 == 0 ? uint64_t { 1 } << 24 : 500;
+        const uint64_t now = wheel.now() + rd() % range;
+        uint64_t last_deadline = 0;
+        wheel.advance( now, [&]( uint32_t id, uint32_t ) {
+          // each expiry happens at its own deadline, in order
+          const auto it = find_if( reference.begin(), reference.end(), [&]( auto& x ) { return x.second == id; } );
+          test_should_be( it != reference.end(), true );
+          test_should_be( it->first, wheel.now() );
+          test_should_be( it->first >= last_deadline, true );
+          last_deadline = it->first;
+          reference.erase( it );
+        } );
+
+        test_should_be( reference.empty() or reference.begin()->first > now, true );
+        test_should_be( wheel.size(), reference.size() );
+      }
+    }
+  } catch ( const exception& e ) {
+    cerr << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
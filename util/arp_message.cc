@@ -1,4 +1,5 @@
 #include "arp_message.hh"
+#include "header_layout.hh"
 
 #include <arpa/inet.h>
 #include <iomanip>
@@ -6,6 +7,19 @@
 
 using namespace std;
 
+namespace {
+using Layout = wire::Layout<ARPMessage::LENGTH,
+                            wire::Field<0, 16>,      // hardware type
+                            wire::Field<16, 16>,     // protocol type
+                            wire::Field<32, 8>,      // hardware address size
+                            wire::Field<40, 8>,      // protocol address size
+                            wire::Field<48, 16>,     // opcode
+                            wire::ByteArray<64, 6>,  // sender Ethernet address
+                            wire::Field<112, 32>,    // sender IP address
+                            wire::ByteArray<144, 6>, // target Ethernet address
+                            wire::Field<192, 32>>;   // target IP address
+} // namespace
+
 bool ARPMessage::supported() const
 {
   return hardware_type == TYPE_ETHERNET and protocol_type == EthernetHeader::TYPE_IPv4
@@ -32,28 +46,20 @@ string ARPMessage::to_string() const
 
 void ARPMessage::parse( Parser& parser )
 {
-  parser.integer( hardware_type );
-  parser.integer( protocol_type );
-  parser.integer( hardware_address_size );
-  parser.integer( protocol_address_size );
-  parser.integer( opcode );
+  Layout::parse( parser,
+                 hardware_type,
+                 protocol_type,
+                 hardware_address_size,
+                 protocol_address_size,
+                 opcode,
+                 sender_ethernet_address,
+                 sender_ip_address,
+                 target_ethernet_address,
+                 target_ip_address );
 
   if ( not supported() ) {
     parser.set_error();
-    return;
-  }
-
-  // read sender addresses (Ethernet and IP)
-  for ( auto& b : sender_ethernet_address ) {
-    parser.integer( b );
-  }
-  parser.integer( sender_ip_address );
-
-  // read target addresses (Ethernet and IP)
-  for ( auto& b : target_ethernet_address ) {
-    parser.integer( b );
   }
-  parser.integer( target_ip_address );
 }
 
 void ARPMessage::serialize( Serializer& serializer ) const
@@ -62,21 +68,14 @@ void ARPMessage::serialize( Serializer& serializer ) const
     throw runtime_error( "ARPMessage: unsupported field combination (must be Ethernet/IP, and request or reply)" );
   }
 
-  serializer.integer( hardware_type );
-  serializer.integer( protocol_type );
-  serializer.integer( hardware_address_size );
-  serializer.integer( protocol_address_size );
-  serializer.integer( opcode );
-
-  // read sender addresses (Ethernet and IP)
-  for ( const auto& b : sender_ethernet_address ) {
-    serializer.integer( b );
-  }
-  serializer.integer( sender_ip_address );
-
-  // read target addresses (Ethernet and IP)
-  for ( const auto& b : target_ethernet_address ) {
-    serializer.integer( b );
-  }
-  serializer.integer( target_ip_address );
+  Layout::serialize( serializer,
+                     hardware_type,
+                     protocol_type,
+                     hardware_address_size,
+                     protocol_address_size,
+                     opcode,
+                     sender_ethernet_address,
+                     sender_ip_address,
+                     target_ethernet_address,
+                     target_ip_address );
 }
@@ -0,0 +1,97 @@
+#include "buffer.hh"
+
+#include <algorithm>
+
+using namespace std;
+
+BufferList::BufferList( vector<string>&& strs )
+{
+  for ( auto& s : strs ) {
+    append( std::move( s ) );
+  }
+}
+
+void BufferList::append( Buffer buffer )
+{
+  if ( buffer.empty() ) {
+    return;
+  }
+  size_ += buffer.size();
+  buffers_.push_back( std::move( buffer ) );
+}
+
+void BufferList::append( const BufferList& other )
+{
+  for ( const auto& b : other ) {
+    append( b );
+  }
+}
+
+void BufferList::remove_prefix( uint64_t n )
+{
+  n = min( n, size_ );
+  size_ -= n;
+
+  auto it = buffers_.begin();
+  while ( n and n >= it->size() ) {
+    n -= it->size();
+    ++it;
+  }
+  buffers_.erase( buffers_.begin(), it );
+
+  if ( n ) {
+    buffers_.front().remove_prefix( n );
+  }
+}
+
+Buffer BufferList::coalesce() const
+{
+  if ( buffers_.empty() ) {
+    return {};
+  }
+  if ( buffers_.size() == 1 ) {
+    return buffers_.front();
+  }
+  return concatenate();
+}
+
+string BufferList::concatenate() const
+{
+  string ret;
+  ret.reserve( size_ );
+  for ( const auto& b : buffers_ ) {
+    ret.append( b.view() );
+  }
+  return ret;
+}
+
+char* BufferArena::extend( size_t len )
+{
+  // move to a fresh block if this one is full, carrying over the pending region
+  if ( not block_ or used_ + len > block_->size() ) {
+    auto block = make_shared<string>( max( block_size_, pending() + len ), '\0' );
+    if ( block_ ) {
+      copy( block_->begin() + static_cast<ptrdiff_t>( start_ ),
+            block_->begin() + static_cast<ptrdiff_t>( used_ ),
+            block->begin() );
+    }
+    block_ = std::move( block );
+    used_ -= start_;
+    start_ = 0;
+  }
+
+  char* ret = block_->data() + used_;
+  fill_n( ret, len, 0 );
+  used_ += len;
+  return ret;
+}
+
+Buffer BufferArena::take()
+{
+  if ( not pending() ) {
+    return {};
+  }
+  Buffer ret { block_, string_view { block_->data() + start_, pending() } };
+  start_ = used_;
+  return ret;
+}
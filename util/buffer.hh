@@ -0,0 +1,122 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+// A reference-counted, read-only slice of a string.
+// Copying or slicing a Buffer shares the underlying bytes instead of copying them;
+// the bytes are freed when the last Buffer that refers to them goes away.
+class Buffer
+{
+  std::shared_ptr<const std::string> storage_ {};
+  std::string_view view_ {};
+
+public:
+  Buffer() = default;
+
+  // Share a region of existing storage
+  Buffer( std::shared_ptr<const std::string> storage, std::string_view view )
+    : storage_( std::move( storage ) ), view_( view )
+  {}
+
+  // Take ownership of a string (no copy)
+  Buffer( std::string&& str ) // NOLINT(*-explicit-*)
+    : storage_( std::make_shared<const std::string>( std::move( str ) ) ), view_( *storage_ )
+  {}
+
+  // Copy a string or literal into a new Buffer
+  Buffer( const std::string& str ) : Buffer( std::string { str } ) {}  // NOLINT(*-explicit-*)
+  Buffer( const char* str ) : Buffer( std::string { str } ) {}         // NOLINT(*-explicit-*)
+  explicit Buffer( std::string_view str ) : Buffer( std::string { str } ) {}
+
+  std::string_view view() const { return view_; }
+  operator std::string_view() const { return view_; } // NOLINT(*-explicit-*)
+  explicit operator std::string() const { return std::string { view_ }; }
+
+  const char* data() const { return view_.data(); }
+  size_t size() const { return view_.size(); }
+  bool empty() const { return view_.empty(); }
+
+  // Discard bytes from either end (the underlying storage is untouched)
+  void remove_prefix( size_t n ) { view_.remove_prefix( n ); }
+  void remove_suffix( size_t n ) { view_.remove_suffix( n ); }
+
+  // A Buffer sharing a sub-range of this one's bytes
+  Buffer substr( size_t pos, size_t len = std::string_view::npos ) const
+  {
+    Buffer ret { *this };
+    ret.view_ = view_.substr( pos, len );
+    return ret;
+  }
+};
+
+// A chain of Buffers, e.g. a packet's headers followed by its payload.
+// Prepending or appending headers, and stripping them off, moves Buffers around instead of copying bytes.
+class BufferList
+{
+  std::vector<Buffer> buffers_ {};
+  uint64_t size_ {};
+
+public:
+  BufferList() = default;
+  explicit BufferList( Buffer buffer ) { append( std::move( buffer ) ); }
+  explicit BufferList( std::vector<std::string>&& strs );
+
+  // Total number of bytes in the chain
+  uint64_t size() const { return size_; }
+  bool empty() const { return size_ == 0; }
+
+  const std::vector<Buffer>& buffers() const { return buffers_; }
+  std::vector<Buffer>::const_iterator begin() const { return buffers_.begin(); }
+  std::vector<Buffer>::const_iterator end() const { return buffers_.end(); }
+
+  void append( Buffer buffer );
+  void append( const BufferList& other );
+
+  // Discard `n` bytes from the front of the chain
+  void remove_prefix( uint64_t n );
+
+  // The whole chain as a single Buffer (shared without copying if it is already one Buffer)
+  Buffer coalesce() const;
+
+  // Copy the whole chain into one string
+  std::string concatenate() const;
+};
+
+// Carves many small Buffers (e.g. packet headers) out of large shared blocks, so that creating one
+// does not need a heap allocation of its own. Bytes are appended to a pending region with extend(),
+// then handed out as a Buffer with take(). A block is freed once the arena has moved on to a new
+// block and every Buffer taken from it is gone.
+class BufferArena
+{
+  std::shared_ptr<std::string> block_ {};
+  size_t start_ {}; // beginning of the pending region
+  size_t used_ {};  // end of the pending region
+  size_t block_size_;
+
+public:
+  static constexpr size_t DEFAULT_BLOCK_SIZE = 65536;
+
+  explicit BufferArena( size_t block_size = DEFAULT_BLOCK_SIZE ) : block_size_( block_size ) {}
+
+  // Buffers taken from the arena point into its blocks, so sharing the write position would be unsafe
+  BufferArena( const BufferArena& other ) = delete;
+  BufferArena& operator=( const BufferArena& other ) = delete;
+  BufferArena( BufferArena&& other ) = default;
+  BufferArena& operator=( BufferArena&& other ) = default;
+  ~BufferArena() = default;
+
+  // Append `len` zeroed bytes to the pending region, and return a pointer to them
+  char* extend( size_t len );
+
+  // Number of bytes in the pending region
+  size_t pending() const { return used_ - start_; }
+
+  // Hand out the pending region as a Buffer, and start a new one
+  Buffer take();
+};
@@ -0,0 +1,215 @@
+#include "checksum.hh"
+
+#include <bit>
+#include <cstring>
+#include <stdexcept>
+
+#if defined( __x86_64__ ) || defined( __i386__ )
+#include <immintrin.h>
+#define CHECKSUM_X86 1
+#endif
+
+using namespace std;
+
+// Each kernel returns the sum of `data` taken as 16-bit words in the machine's byte order (with a
+// trailing odd byte as the low half of a final word), folded to 16 bits with end-around carry. In
+// ones' complement arithmetic, byte-swapping every word byte-swaps the sum (RFC 1071), so the
+// network-order sum is recovered with a single swap at the end.
+
+namespace {
+
+uint16_t fold( uint64_t sum )
+{
+  while ( sum > 0xffff ) {
+    sum = ( sum >> 16 ) + ( sum & 0xffff );
+  }
+  return sum;
+}
+
+uint16_t swap_bytes( uint16_t val )
+{
+  return static_cast<uint16_t>( ( val << 8 ) | ( val >> 8 ) );
+}
+
+uint64_t load_u64( const char* p )
+{
+  uint64_t val {};
+  memcpy( &val, p, sizeof( val ) );
+  return val;
+}
+
+// The remaining (fewer than 8) bytes, in native byte order
+uint64_t sum_tail( const char* p, size_t len )
+{
+  uint64_t tail = 0;
+  memcpy( &tail, p, len );
+  return ( tail >> 32 ) + ( tail & 0xffff'ffff );
+}
+
+uint16_t sum_bytewise( string_view data )
+{
+  // big-endian, like the original loop; converted to native order for the caller
+  uint64_t sum = 0;
+  bool odd = false;
+  for ( const uint8_t byte : data ) {
+    sum += odd ? byte : static_cast<uint64_t>( byte ) << 8;
+    odd = !odd;
+  }
+  const uint16_t be = fold( sum );
+  return std::endian::native == std::endian::little ? swap_bytes( be ) : be;
+}
+
+uint16_t sum_word64( string_view data )
+{
+  const char* p = data.data();
+  size_t len = data.size();
+
+  // two independent accumulators of 32-bit halves; neither can overflow before 2^31 iterations
+  uint64_t sum0 = 0;
+  uint64_t sum1 = 0;
+  while ( len >= 16 ) {
+    const uint64_t a = load_u64( p );
+    const uint64_t b = load_u64( p + 8 );
+    sum0 += ( a >> 32 ) + ( a & 0xffff'ffff );
+    sum1 += ( b >> 32 ) + ( b & 0xffff'ffff );
+    p += 16;
+    len -= 16;
+  }
+  if ( len >= 8 ) {
+    const uint64_t a = load_u64( p );
+    sum0 += ( a >> 32 ) + ( a & 0xffff'ffff );
+    p += 8;
+    len -= 8;
+  }
+
+  return fold( sum0 + sum1 + sum_tail( p, len ) );
+}
+
+#ifdef CHECKSUM_X86
+__attribute__( ( target( "sse2" ) ) ) uint16_t sum_sse2( string_view data )
+{
+  const char* p = data.data();
+  size_t len = data.size();
+
+  // widen each 32-bit lane to 64 bits before adding, so the accumulators cannot overflow
+  const __m128i zero = _mm_setzero_si128();
+  __m128i acc0 = zero;
+  __m128i acc1 = zero;
+  while ( len >= 16 ) {
+    const __m128i v = _mm_loadu_si128( reinterpret_cast<const __m128i*>( p ) );
+    acc0 = _mm_add_epi64( acc0, _mm_unpacklo_epi32( v, zero ) );
+    acc1 = _mm_add_epi64( acc1, _mm_unpackhi_epi32( v, zero ) );
+    p += 16;
+    len -= 16;
+  }
+
+  const __m128i acc = _mm_add_epi64( acc0, acc1 );
+  uint64_t sum = static_cast<uint64_t>( _mm_cvtsi128_si64( acc ) )
+                 + static_cast<uint64_t>( _mm_cvtsi128_si64( _mm_unpackhi_epi64( acc, acc ) ) );
+
+  if ( len >= 8 ) {
+    const uint64_t a = load_u64( p );
+    sum += ( a >> 32 ) + ( a & 0xffff'ffff );
+    p += 8;
+    len -= 8;
+  }
+
+  return fold( sum + sum_tail( p, len ) );
+}
+
+__attribute__( ( target( "avx2" ) ) ) uint16_t sum_avx2( string_view data )
+{
+  const char* p = data.data();
+  size_t len = data.size();
+
+  const __m256i zero = _mm256_setzero_si256();
+  __m256i acc0 = zero;
+  __m256i acc1 = zero;
+  while ( len >= 32 ) {
+    const __m256i v = _mm256_loadu_si256( reinterpret_cast<const __m256i*>( p ) );
+    acc0 = _mm256_add_epi64( acc0, _mm256_unpacklo_epi32( v, zero ) );
+    acc1 = _mm256_add_epi64( acc1, _mm256_unpackhi_epi32( v, zero ) );
+    p += 32;
+    len -= 32;
+  }
+
+  const __m256i acc256 = _mm256_add_epi64( acc0, acc1 );
+  const __m128i acc
+    = _mm_add_epi64( _mm256_castsi256_si128( acc256 ), _mm256_extracti128_si256( acc256, 1 ) );
+  const uint64_t sum = static_cast<uint64_t>( _mm_cvtsi128_si64( acc ) )
+                       + static_cast<uint64_t>( _mm_cvtsi128_si64( _mm_unpackhi_epi64( acc, acc ) ) );
+
+  return fold( sum + sum_word64( { p, len } ) );
+}
+#endif
+
+using SumFunction = uint16_t ( * )( string_view );
+
+SumFunction sum_function( InternetChecksum::Kernel kernel )
+{
+  switch ( kernel ) {
+    case InternetChecksum::Kernel::Bytewise:
+      return sum_bytewise;
+    case InternetChecksum::Kernel::Word64:
+      return sum_word64;
+#ifdef CHECKSUM_X86
+    case InternetChecksum::Kernel::SSE2:
+      return sum_sse2;
+    case InternetChecksum::Kernel::AVX2:
+      return sum_avx2;
+#endif
+    default:
+      throw runtime_error( "InternetChecksum kernel not supported on this machine" );
+  }
+}
+
+} // namespace
+
+bool InternetChecksum::supported( const Kernel kernel )
+{
+  switch ( kernel ) {
+    case Kernel::Bytewise:
+    case Kernel::Word64:
+      return true;
+#ifdef CHECKSUM_X86
+    case Kernel::SSE2:
+      __builtin_cpu_init(); // may run before libgcc's own initialization (e.g. from a static constructor)
+      return __builtin_cpu_supports( "sse2" );
+    case Kernel::AVX2:
+      __builtin_cpu_init();
+      return __builtin_cpu_supports( "avx2" );
+#endif
+    default:
+      return false;
+  }
+}
+
+InternetChecksum::Kernel InternetChecksum::best_kernel()
+{
+  for ( const auto kernel : { Kernel::AVX2, Kernel::SSE2 } ) {
+    if ( supported( kernel ) ) {
+      return kernel;
+    }
+  }
+  return Kernel::Word64;
+}
+
+static void accumulate( uint64_t& sum, bool& parity, const string_view data, const uint16_t native_sum )
+{
+  // An odd number of bytes so far means this data starts in the low half of a (network-order) word,
+  // which is the same as summing it in swapped order.
+  const bool little_endian = std::endian::native == std::endian::little;
+  sum += ( little_endian != parity ) ? swap_bytes( native_sum ) : native_sum;
+  parity ^= ( data.size() % 2 );
+}
+
+void InternetChecksum::add( const string_view data )
+{
+  static const SumFunction best_sum_function = sum_function( best_kernel() );
+  accumulate( sum_, parity_, data, best_sum_function( data ) );
+}
+
+void InternetChecksum::add( const string_view data, const Kernel kernel )
+{
+  accumulate( sum_, parity_, data, sum_function( kernel )( data ) );
+}
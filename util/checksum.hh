@@ -1,33 +1,42 @@
 #pragma once
 
+#include "buffer.hh"
+
 #include <cstdint>
 #include <string>
+#include <string_view>
 #include <vector>
 
 //! The internet checksum algorithm
 class InternetChecksum
 {
+public:
+  // Implementations of the summing loop. All of them give identical results; add() uses the
+  // fastest one the CPU supports.
+  enum class Kernel
+  {
+    Bytewise, // one byte at a time (the reference implementation)
+    Word64,   // 64-bit words, portable
+    SSE2,     // 128-bit vectors (x86)
+    AVX2,     // 256-bit vectors (x86)
+  };
+
+  static bool supported( Kernel kernel );
+  static Kernel best_kernel();
+
 private:
-  uint32_t sum_;
-  bool parity_ {};
+  uint64_t sum_;
+  bool parity_ {}; // has an odd number of bytes been added so far?
 
 public:
   explicit InternetChecksum( const uint32_t sum = 0 ) : sum_( sum ) {}
-  void add( std::string_view data )
-  {
-    for ( const uint8_t i : data ) {
-      uint16_t val = i;
-      if ( not parity_ ) {
-        val <<= 8;
-      }
-      sum_ += val;
-      parity_ = !parity_;
-    }
-  }
+
+  void add( std::string_view data );
+  void add( std::string_view data, Kernel kernel );
 
   uint16_t value() const
   {
-    uint32_t ret = sum_;
+    uint64_t ret = sum_;
 
     while ( ret > 0xffff ) {
       ret = ( ret >> 16 ) + static_cast<uint16_t>( ret );
@@ -36,7 +45,24 @@ public:
     return ~ret;
   }
 
-  void add( const std::vector<std::string>& data )
+  // Update an existing checksum in O(1) when one 16-bit word of the checksummed data changes from
+  // `old_word` to `new_word` (RFC 1624, eqn. 3). Gives the same result as recomputing it from scratch.
+  static uint16_t adjust( uint16_t checksum, uint16_t old_word, uint16_t new_word )
+  {
+    uint32_t sum = static_cast<uint16_t>( ~checksum ) + static_cast<uint16_t>( ~old_word ) + new_word;
+    sum = ( sum >> 16 ) + ( sum & 0xffff );
+    sum = ( sum >> 16 ) + ( sum & 0xffff );
+    return ~sum;
+  }
+
+  // Same, for a 32-bit field (e.g. an IPv4 address) aligned to a 16-bit boundary
+  static uint16_t adjust32( uint16_t checksum, uint32_t old_value, uint32_t new_value )
+  {
+    checksum = adjust( checksum, old_value >> 16, new_value >> 16 );
+    return adjust( checksum, static_cast<uint16_t>( old_value ), static_cast<uint16_t>( new_value ) );
+  }
+
+  void add( const BufferList& data )
   {
     for ( const auto& x : data ) {
       add( x );
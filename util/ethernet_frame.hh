@@ -1,14 +1,13 @@
 #pragma once
 
+#include "buffer.hh"
 #include "ethernet_header.hh"
 #include "parser.hh"
 
-#include <vector>
-
 struct EthernetFrame
 {
   EthernetHeader header {};
-  std::vector<std::string> payload {};
+  BufferList payload {};
 
   void parse( Parser& parser )
   {
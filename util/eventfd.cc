@@ -0,0 +1,28 @@
+#include "eventfd.hh"
+#include "exception.hh"
+
+#include <cerrno>
+#include <cstdint>
+#include <string>
+#include <sys/eventfd.h>
+
+using namespace std;
+
+EventFD::EventFD() : FileDescriptor( ::CheckSystemCall( "eventfd", eventfd( 0, EFD_NONBLOCK | EFD_CLOEXEC ) ) ) {}
+
+void EventFD::notify()
+{
+  // Called from threads other than the one that owns the descriptor, so go straight to the system call rather
+  // than through FileDescriptor::write (whose read/write counters are not thread-safe). EAGAIN only means the
+  // counter is saturated, i.e. the eventfd is readable already.
+  if ( ::eventfd_write( fd_num(), 1 ) < 0 and errno != EAGAIN ) {
+    throw unix_error( "eventfd_write" );
+  }
+}
+
+bool EventFD::clear()
+{
+  string buffer( sizeof( uint64_t ), '\0' );
+  read( buffer );
+  return not buffer.empty();
+}
@@ -0,0 +1,17 @@
+#pragma once
+
+#include "file_descriptor.hh"
+
+//! A non-blocking FileDescriptor to a Linux [eventfd](\ref man2::eventfd) counter, used to wake an EventLoop
+//! from another thread
+class EventFD : public FileDescriptor
+{
+public:
+  EventFD();
+
+  //! Make the eventfd readable (wakes anyone polling it); safe to call from any thread
+  void notify();
+
+  //! Reset the counter so the eventfd is no longer readable; returns whether it had been notified
+  bool clear();
+};
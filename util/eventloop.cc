@@ -1,7 +1,10 @@
 #include "eventloop.hh"
 #include "exception.hh"
+#include "io_uring.hh"
 #include "socket.hh"
 
+#include <algorithm>
+#include <cerrno>
 #include <cstring>
 #include <iomanip>
 #include <iostream>
@@ -78,72 +81,333 @@ void EventLoop::RuleHandle::cancel()
   }
 }
 
-// NOLINTBEGIN(*-cognitive-complexity)
-// NOLINTBEGIN(*-signed-bitwise)
-EventLoop::Result EventLoop::wait_next_event( const int timeout_ms )
+namespace {
+
+uint32_t epoll_event_for( const Direction direction )
 {
-  // first, handle the non-file-descriptor-related rules
-  {
-    for ( auto it = _non_fd_rules.begin(); it != _non_fd_rules.end(); ) {
-      auto& this_rule = **it;
-      bool rule_fired = false;
+  return direction == Direction::In ? EPOLLIN : EPOLLOUT;
+}
 
-      if ( this_rule.cancel_requested ) {
-        it = _non_fd_rules.erase( it );
-        continue;
-      }
+// epoll reports the same conditions as poll; translate so all backends share the event handling
+int16_t poll_events_from_epoll( const uint32_t events )
+{
+  int16_t ret = 0;
+  ret |= ( events & EPOLLIN ) ? POLLIN : 0;
+  ret |= ( events & EPOLLOUT ) ? POLLOUT : 0;
+  ret |= ( events & EPOLLERR ) ? POLLERR : 0;
+  ret |= ( events & EPOLLHUP ) ? POLLHUP : 0;
+  return ret;
+}
 
-      uint8_t iterations = 0;
-      while ( this_rule.interest() ) {
-        if ( iterations++ >= 128 ) {
-          throw runtime_error( "EventLoop: busy wait detected: rule \""
-                               + _rule_categories.at( this_rule.category_id ).name + "\" is still interested after "
-                               + to_string( iterations ) + " iterations" );
-        }
+template<class Buffers>
+size_t total_size( const Buffers& buffers )
+{
+  size_t ret = 0;
+  for ( const auto& buffer : buffers ) {
+    ret += buffer.size();
+  }
+  return ret;
+}
 
-        rule_fired = true;
-        this_rule.callback();
-      }
+// What an io_uring completion is for: the top two bits of its user_data
+enum class UringTag : uint64_t
+{
+  Poll = 0,       // readiness of a watched fd (value: token << 32 | fd number)
+  LinkedPoll = 1, // the readiness wait in front of a chain of reads or writes (value: chain)
+  Operation = 2,  // a read or write (value: chain << 3 | position in the chain)
+  Ignore = 3      // a cancellation
+};
+constexpr uint64_t URING_VALUE_MASK = ( uint64_t { 1 } << 62 ) - 1;
+constexpr uint32_t URING_TOKEN_MASK = ( uint32_t { 1 } << 30 ) - 1;
+
+uint64_t uring_data( const UringTag tag, const uint64_t value )
+{
+  return static_cast<uint64_t>( tag ) << 62 | value;
+}
 
-      if ( rule_fired ) {
-        return Result::Success; /* only serve one rule on each iteration */
+} // namespace
+
+EventLoop::EventLoop( const Backend backend ) : _backend( backend )
+{
+  _rule_categories.reserve( 64 );
+
+  if ( _backend == Backend::IoUring ) {
+    try {
+      setup_uring();
+    } catch ( const exception& ) {
+      // io_uring is missing, too old, or disabled (e.g. by the kernel.io_uring_disabled sysctl or a seccomp
+      // filter): use epoll instead
+      _ring.reset();
+      _backend = Backend::Epoll;
+    }
+  }
+
+  if ( _backend == Backend::Epoll ) {
+    _epoll.emplace( CheckSystemCall( "epoll_create1", ::epoll_create1( EPOLL_CLOEXEC ) ) );
+    _epoll_events.resize( 64 );
+  }
+}
+
+EventLoop::~EventLoop()
+{
+  if ( not _ring ) {
+    return;
+  }
+
+  // the kernel may still be reading into (or writing from) the rules' memory: cancel whatever is in flight, and
+  // wait until it is done with it
+  try {
+    size_t pending = 0;
+    for ( size_t chain = 0; chain < _uring_chains.size(); ++chain ) {
+      if ( _uring_chains[chain].pending > 0 ) {
+        cancel_uring_chain( static_cast<int>( chain ) );
+        pending += _uring_chains[chain].pending;
       }
+    }
+    while ( pending > 0 ) {
+      _ring->submit_and_wait( -1 );
+      _ring->for_each_completion( [&]( const io_uring_cqe& cqe ) {
+        const auto tag = static_cast<UringTag>( cqe.user_data >> 62 );
+        if ( tag == UringTag::Operation or tag == UringTag::LinkedPoll ) {
+          --pending;
+        }
+      } );
+    }
+  } catch ( const exception& e ) {
+    cerr << "EventLoop: " << e.what() << "\n";
+  }
+}
 
-      ++it;
+void EventLoop::register_memory( const span<char> region )
+{
+  if ( not _uring_fixed or _uring_regions.size() >= URING_REGIONS ) {
+    return;
+  }
+
+  try {
+    _ring->update_buffer( _uring_regions.size(), { region.data(), region.size() } );
+    _uring_regions.push_back( region );
+  } catch ( const unix_error& ) {
+    // e.g. over RLIMIT_MEMLOCK (on kernels that still charge it): plain reads and writes work as well
+  }
+}
+
+EventLoop::RuleHandle EventLoop::add_read_rule( const size_t category_id,
+                                                FileDescriptor& fd,
+                                                const ReadSpaceT& space,
+                                                const DoneT& done,
+                                                const InterestT& interest,
+                                                const CallbackT& cancel, // NOLINT(*-easily-swappable-*)
+                                                const CallbackT& error )
+{
+  if ( category_id >= _rule_categories.size() ) {
+    throw out_of_range( "bad category_id" );
+  }
+
+  auto rule = make_shared<FDRule>( BasicRule { category_id, {}, {} }, fd.duplicate(), Direction::In, cancel, error );
+  rule->read_space = space;
+  rule->done = done;
+
+  // with poll and epoll, the rule reads when the fd is readable, like any other rule
+  FDRule& this_rule = *rule;
+  rule->interest = [&this_rule, interest] { return interest() and total_size( this_rule.read_space() ) > 0; };
+  rule->callback = [&this_rule] {
+    const auto spans = this_rule.read_space();
+    const size_t bytes_read = this_rule.fd.read( span<const span<char>> { spans } );
+    if ( bytes_read ) {
+      this_rule.done( bytes_read );
     }
+  };
+
+  _fd_rules.push_back( std::move( rule ) );
+  return RuleHandle { _fd_rules.back() };
+}
+
+EventLoop::RuleHandle EventLoop::add_write_rule( const size_t category_id,
+                                                 FileDescriptor& fd,
+                                                 const WriteDataT& data,
+                                                 const DoneT& done,
+                                                 const InterestT& interest,
+                                                 const CallbackT& cancel, // NOLINT(*-easily-swappable-*)
+                                                 const CallbackT& error )
+{
+  if ( category_id >= _rule_categories.size() ) {
+    throw out_of_range( "bad category_id" );
   }
 
-  // now the file-descriptor-related rules. poll any "interested" file descriptors
-  vector<pollfd> pollfds {};
-  pollfds.reserve( _fd_rules.size() );
-  bool something_to_poll = false;
+  auto rule = make_shared<FDRule>( BasicRule { category_id, {}, {} }, fd.duplicate(), Direction::Out, cancel, error );
+  rule->write_data = data;
+  rule->done = done;
+
+  // with poll and epoll, the rule writes when the fd is writable, like any other rule
+  FDRule& this_rule = *rule;
+  rule->interest = [&this_rule, interest] { return interest() and total_size( this_rule.write_data() ) > 0; };
+  rule->callback = [&this_rule] {
+    const auto views = this_rule.write_data();
+    const size_t bytes_written = this_rule.fd.write( span<const string_view> { views } );
+    if ( bytes_written ) {
+      this_rule.done( bytes_written );
+    }
+  };
 
-  // set up the pollfd for each rule
-  for ( auto it = _fd_rules.begin(); it != _fd_rules.end(); ) { // NOTE: it gets erased or incremented in loop body
+  _fd_rules.push_back( std::move( rule ) );
+  return RuleHandle { _fd_rules.back() };
+}
+
+EventLoop::Result EventLoop::wait_next_event( const int timeout_ms )
+{
+  // first, handle the non-file-descriptor-related rules
+  if ( serve_non_fd_rules() ) {
+    return Result::Success; /* only serve one rule on each iteration */
+  }
+
+  switch ( _backend ) {
+    case Backend::Epoll:
+      return wait_epoll( timeout_ms );
+    case Backend::IoUring:
+      return wait_uring( timeout_ms );
+    case Backend::Poll:
+      break;
+  }
+  return wait_poll( timeout_ms );
+}
+
+bool EventLoop::serve_non_fd_rules()
+{
+  for ( auto it = _non_fd_rules.begin(); it != _non_fd_rules.end(); ) {
     auto& this_rule = **it;
+    bool rule_fired = false;
 
     if ( this_rule.cancel_requested ) {
-      //      this_rule.cancel();
-      //      if rule is cancelled externally, no need to call the cancellation callback
-      //      this makes it easier to cancel rules and delete captured objects right away
-      it = _fd_rules.erase( it );
+      it = _non_fd_rules.erase( it );
       continue;
     }
 
-    if ( this_rule.direction == Direction::In && this_rule.fd.eof() ) {
-      // no more reading on this rule, it's reached eof
-      this_rule.cancel();
-      it = _fd_rules.erase( it );
-      continue;
+    uint8_t iterations = 0;
+    while ( this_rule.interest() ) {
+      if ( iterations++ >= 128 ) {
+        throw runtime_error( "EventLoop: busy wait detected: rule \""
+                             + _rule_categories.at( this_rule.category_id ).name + "\" is still interested after "
+                             + to_string( iterations ) + " iterations" );
+      }
+
+      rule_fired = true;
+      this_rule.callback();
+    }
+
+    if ( rule_fired ) {
+      return true;
+    }
+
+    ++it;
+  }
+
+  return false;
+}
+
+bool EventLoop::retire_fd_rule( FDRuleList::iterator& it )
+{
+  auto& this_rule = **it;
+
+  if ( this_rule.cancel_requested ) {
+    //      this_rule.cancel();
+    //      if rule is cancelled externally, no need to call the cancellation callback
+    //      this makes it easier to cancel rules and delete captured objects right away
+    it = _fd_rules.erase( it );
+    return true;
+  }
+
+  if ( this_rule.direction == Direction::In && this_rule.fd.eof() ) {
+    // no more reading on this rule, it's reached eof
+    this_rule.cancel();
+    it = _fd_rules.erase( it );
+    return true;
+  }
+
+  if ( this_rule.fd.closed() ) {
+    this_rule.cancel();
+    it = _fd_rules.erase( it );
+    return true;
+  }
+
+  return false;
+}
+
+// NOLINTBEGIN(*-signed-bitwise)
+EventLoop::FDOutcome EventLoop::handle_fd_event( FDRuleList::iterator& it,
+                                                 const int16_t asked,
+                                                 const int16_t revents )
+{
+  auto& this_rule = **it;
+
+  const auto poll_error = static_cast<bool>( revents & ( POLLERR | POLLNVAL ) );
+  if ( poll_error ) {
+    /* see if fd is a socket */
+    int socket_error = 0;
+    socklen_t optlen = sizeof( socket_error );
+    const int ret = getsockopt( this_rule.fd.fd_num(), SOL_SOCKET, SO_ERROR, &socket_error, &optlen );
+    if ( ret == -1 and errno == ENOTSOCK ) {
+      cerr << "error on polled file descriptor for rule \"" << _rule_categories.at( this_rule.category_id ).name
+           << "\"\n";
+    } else if ( ret == -1 ) {
+      throw unix_error( "getsockopt" );
+    } else if ( optlen != sizeof( socket_error ) ) {
+      throw runtime_error( "unexpected length from getsockopt: " + to_string( optlen ) );
+    } else if ( socket_error ) {
+      cerr << "error on polled socket for rule \"" << _rule_categories.at( this_rule.category_id ).name
+           << "\": " << strerror( socket_error ) << "\n";
+    }
+
+    this_rule.error();
+    this_rule.cancel();
+    it = _fd_rules.erase( it );
+    return FDOutcome::Removed;
+  }
+
+  const auto poll_ready = static_cast<bool>( revents & asked );
+  const auto poll_hup = static_cast<bool>( revents & POLLHUP );
+  if ( poll_hup && ( ( asked && !poll_ready ) or ( this_rule.direction == Direction::Out ) ) ) {
+    // if we asked for the status, and the _only_ condition was a hangup, this FD is defunct:
+    //   - if it was POLLIN and nothing is readable, no more will ever be readable
+    //   - if it was POLLOUT, it will not be writable again
+    // additionally, consider FD defunct if rule will only query for Direction::Out
+    this_rule.cancel();
+    it = _fd_rules.erase( it );
+    return FDOutcome::Removed;
+  }
+
+  if ( poll_ready ) {
+    // we only want to call callback if revents includes the event we asked for
+    const auto count_before = this_rule.service_count();
+    this_rule.callback();
+
+    if ( count_before == this_rule.service_count() and ( not this_rule.fd.closed() ) and this_rule.interest() ) {
+      throw runtime_error( "EventLoop: busy wait detected: rule \"" + _rule_categories.at( this_rule.category_id ).name
+                           + "\" did not read/write fd and is still interested" );
     }
 
-    if ( this_rule.fd.closed() ) {
-      this_rule.cancel();
-      it = _fd_rules.erase( it );
+    return FDOutcome::Served;
+  }
+
+  return FDOutcome::Idle;
+}
+
+EventLoop::Result EventLoop::wait_poll( const int timeout_ms )
+{
+  // poll any "interested" file descriptors
+  vector<pollfd> pollfds {};
+  pollfds.reserve( _fd_rules.size() );
+  bool something_to_poll = false;
+
+  // set up the pollfd for each rule
+  for ( auto it = _fd_rules.begin(); it != _fd_rules.end(); ) { // NOTE: it gets erased or incremented in loop body
+    if ( retire_fd_rule( it ) ) {
       continue;
     }
 
-    if ( this_rule.interest() ) {
+    auto& this_rule = **it;
+    this_rule.interested = this_rule.interest();
+    if ( this_rule.interested ) {
       pollfds.push_back( { this_rule.fd.fd_num(), static_cast<int16_t>( this_rule.direction ), 0 } );
       something_to_poll = true;
     } else {
@@ -165,62 +429,472 @@ EventLoop::Result EventLoop::wait_next_event( const int timeout_ms )
   // go through the poll results
   for ( auto [it, idx] = make_pair( _fd_rules.begin(), static_cast<size_t>( 0 ) ); it != _fd_rules.end(); ++idx ) {
     const auto& this_pollfd = pollfds.at( idx );
+    switch ( handle_fd_event( it, this_pollfd.events, this_pollfd.revents ) ) {
+      case FDOutcome::Removed:
+        continue;
+      case FDOutcome::Served:
+        return Result::Success; /* only serve one rule on each iteration */
+      case FDOutcome::Idle:
+        ++it; // if we got here, it means we didn't call _fd_rules.erase()
+    }
+  }
+
+  return Result::Success;
+}
+
+bool EventLoop::collect_interest( const bool skip_io )
+{
+  for ( auto& [fd_num, entry] : _watched_fds ) {
+    entry.wanted = 0;
+    entry.rules.clear();
+  }
+
+  bool something_to_poll = false;
+  for ( auto it = _fd_rules.begin(); it != _fd_rules.end(); ) {
+    const int fd_num = ( *it )->fd.fd_num();
+    const bool closed = ( *it )->fd.closed();
+    if ( retire_fd_rule( it ) ) {
+      const auto entry = _watched_fds.find( fd_num );
+      if ( closed and entry != _watched_fds.end() ) {
+        entry->second.reset = true;
+      }
+      continue;
+    }
+
     auto& this_rule = **it;
+    if ( skip_io and this_rule.is_io() ) {
+      ++it;
+      continue;
+    }
 
-    const auto poll_error = static_cast<bool>( this_pollfd.revents & ( POLLERR | POLLNVAL ) );
-    if ( poll_error ) {
-      /* see if fd is a socket */
-      int socket_error = 0;
-      socklen_t optlen = sizeof( socket_error );
-      const int ret = getsockopt( this_rule.fd.fd_num(), SOL_SOCKET, SO_ERROR, &socket_error, &optlen );
-      if ( ret == -1 and errno == ENOTSOCK ) {
-        cerr << "error on polled file descriptor for rule \"" << _rule_categories.at( this_rule.category_id ).name
-             << "\"\n";
-      } else if ( ret == -1 ) {
-        throw unix_error( "getsockopt" );
-      } else if ( optlen != sizeof( socket_error ) ) {
-        throw runtime_error( "unexpected length from getsockopt: " + to_string( optlen ) );
-      } else if ( socket_error ) {
-        cerr << "error on polled socket for rule \"" << _rule_categories.at( this_rule.category_id ).name
-             << "\": " << strerror( socket_error ) << "\n";
+    auto& entry = _watched_fds[this_rule.fd.fd_num()];
+    this_rule.interested = this_rule.interest();
+    if ( this_rule.interested ) {
+      entry.wanted |= epoll_event_for( this_rule.direction );
+      something_to_poll = true;
+    }
+    entry.rules.push_back( it ); // watched even if uninterested --- we still want errors
+    ++it;
+  }
+
+  return something_to_poll;
+}
+
+void EventLoop::epoll_update( const int fd_num, WatchedFD& entry )
+{
+  epoll_event event {};
+  event.events = entry.wanted;
+  event.data.fd = fd_num;
+
+  if ( entry.registered ) {
+    if ( entry.events == entry.wanted ) {
+      return;
+    }
+    if ( ::epoll_ctl( _epoll->fd_num(), EPOLL_CTL_MOD, fd_num, &event ) == 0 ) {
+      entry.events = entry.wanted;
+      return;
+    }
+    if ( errno != ENOENT ) {
+      throw unix_error( "epoll_ctl" );
+    }
+    // the kernel dropped the registration when the fd was closed, and the number has been reused since
+    entry.registered = false;
+  }
+
+  if ( ::epoll_ctl( _epoll->fd_num(), EPOLL_CTL_ADD, fd_num, &event ) == 0 ) {
+    entry.registered = true;
+    entry.events = entry.wanted;
+    return;
+  }
+  if ( errno != EPERM ) {
+    throw unix_error( "epoll_ctl" );
+  }
+  // epoll does not support this kind of fd (e.g. a regular file); like poll, treat it as always ready
+  entry.pollable = false;
+}
+
+EventLoop::Result EventLoop::wait_epoll( const int timeout_ms )
+{
+  // The fds stay registered from one wait to the next, so the kernel only has to report the ready ones.
+  // The rules' interest() is still asked every time, but a rule whose interest has not changed costs no
+  // system call: epoll_ctl() is only called when the set of events wanted on an fd changes.
+  const bool something_to_poll = collect_interest( false );
+
+  bool always_ready = false;
+  for ( auto entry_it = _watched_fds.begin(); entry_it != _watched_fds.end(); ) {
+    auto& [fd_num, entry] = *entry_it;
+    if ( entry.rules.empty() ) {
+      // no rules left on this fd (it may already be closed, in which case the kernel has forgotten it)
+      if ( entry.registered ) {
+        ::epoll_ctl( _epoll->fd_num(), EPOLL_CTL_DEL, fd_num, nullptr );
+      }
+      entry_it = _watched_fds.erase( entry_it );
+      continue;
+    }
+
+    if ( entry.reset ) {
+      // a rule's fd was closed, and this number now belongs to another rule's fd: start over
+      if ( entry.registered ) {
+        ::epoll_ctl( _epoll->fd_num(), EPOLL_CTL_DEL, fd_num, nullptr );
+      }
+      auto rules = std::move( entry.rules );
+      entry = WatchedFD {};
+      entry.rules = std::move( rules );
+    }
+
+    if ( entry.pollable ) {
+      epoll_update( fd_num, entry );
+    }
+    always_ready |= ( not entry.pollable ) and entry.wanted;
+    ++entry_it;
+  }
+
+  // quit if there is nothing left to poll
+  if ( not something_to_poll ) {
+    return Result::Exit;
+  }
+
+  const int num_events = CheckSystemCall(
+    "epoll_wait",
+    ::epoll_wait(
+      _epoll->fd_num(), _epoll_events.data(), static_cast<int>( _epoll_events.size() ), always_ready ? 0 : timeout_ms ) );
+
+  _ready.clear();
+  for ( int i = 0; i < num_events; ++i ) {
+    const int fd_num = _epoll_events[i].data.fd;
+    _ready.emplace_back( fd_num, poll_events_from_epoll( _epoll_events[i].events ) );
+  }
+  if ( always_ready ) {
+    for ( const auto& [fd_num, entry] : _watched_fds ) {
+      if ( not entry.pollable and entry.wanted ) {
+        _ready.emplace_back( fd_num, poll_events_from_epoll( entry.wanted ) );
+      }
+    }
+  }
+
+  if ( _ready.empty() ) {
+    return Result::Timeout;
+  }
+
+  // go through the ready fds, and the rules on each
+  for ( const auto& [fd_num, revents] : _ready ) {
+    const auto entry = _watched_fds.find( fd_num );
+    if ( entry == _watched_fds.end() ) {
+      continue;
+    }
+    for ( auto it : entry->second.rules ) {
+      const auto asked = static_cast<int16_t>( ( *it )->interested ? static_cast<int16_t>( ( *it )->direction ) : 0 );
+      if ( handle_fd_event( it, asked, revents ) == FDOutcome::Served ) {
+        return Result::Success; /* only serve one rule on each iteration */
+      }
+    }
+  }
+
+  return Result::Success;
+}
+
+void EventLoop::setup_uring()
+{
+  _ring = make_unique<IoUring>( 256 );
+
+  // Fixed buffers save the kernel from mapping the pages of the rules' memory on every read and write. The
+  // table starts empty and register_memory() fills it in; without it (before Linux 5.19), the same memory is
+  // used with plain reads and writes.
+  try {
+    _ring->register_buffer_table( URING_REGIONS );
+    _uring_fixed = true;
+  } catch ( const unix_error& ) {
+    _uring_fixed = false;
+  }
+}
+
+void EventLoop::cancel_uring( const uint64_t user_data )
+{
+  io_uring_sqe& sqe = _ring->get_sqe();
+  sqe.opcode = IORING_OP_ASYNC_CANCEL;
+  sqe.addr = user_data;
+  sqe.user_data = uring_data( UringTag::Ignore, 0 );
+}
+
+void EventLoop::arm_uring_poll( const int fd_num, WatchedFD& entry )
+{
+  entry.token = ++_uring_token & URING_TOKEN_MASK;
+  entry.events = entry.wanted;
+  entry.registered = true;
+
+  io_uring_sqe& sqe = _ring->get_sqe();
+  sqe.opcode = IORING_OP_POLL_ADD;
+  sqe.fd = fd_num;
+  sqe.poll32_events = static_cast<uint16_t>( poll_events_from_epoll( entry.wanted ) );
+  sqe.user_data = uring_data( UringTag::Poll, uint64_t { entry.token } << 32 | static_cast<uint32_t>( fd_num ) );
+}
+
+int EventLoop::uring_region_of( const char* data, const size_t size ) const
+{
+  for ( size_t slot = 0; slot < _uring_regions.size(); ++slot ) {
+    const auto& region = _uring_regions[slot];
+    if ( data >= region.data() and data + size <= region.data() + region.size() ) {
+      return static_cast<int>( slot );
+    }
+  }
+  return -1;
+}
+
+void EventLoop::cancel_uring_chain( const int chain )
+{
+  auto& this_chain = _uring_chains.at( chain );
+  if ( this_chain.cancelled ) {
+    return;
+  }
+  this_chain.cancelled = true;
+
+  if ( this_chain.poll_first ) {
+    cancel_uring( uring_data( UringTag::LinkedPoll, chain ) );
+  }
+  for ( size_t op = 0; op < this_chain.ops; ++op ) {
+    cancel_uring( uring_data( UringTag::Operation, static_cast<uint64_t>( chain ) << 3 | op ) );
+  }
+}
+
+bool EventLoop::submit_uring_chain( const shared_ptr<FDRule>& rule )
+{
+  const bool read = rule->direction == Direction::In;
+
+  // cut the rule's memory into consecutive pieces of at most URING_CHUNK_SIZE, one read or write each
+  array<span<char>, UringChain::MAX_OPS> pieces {};
+  size_t ops = 0;
+  const auto add = [&]( char* data, size_t size ) {
+    while ( size > 0 and ops < pieces.size() ) {
+      const size_t n = min( size, URING_CHUNK_SIZE );
+      pieces.at( ops++ ) = { data, n };
+      data += n;
+      size -= n;
+    }
+  };
+  if ( read ) {
+    for ( const auto space : rule->read_space() ) {
+      add( space.data(), space.size() );
+    }
+  } else {
+    for ( const auto view : rule->write_data() ) {
+      add( const_cast<char*>( view.data() ), view.size() ); // NOLINT(*-const-cast)
+    }
+  }
+  if ( ops == 0 ) {
+    return false;
+  }
+
+  int chain = 0;
+  if ( _uring_free_chains.empty() ) {
+    chain = static_cast<int>( _uring_chains.size() );
+    _uring_chains.emplace_back();
+  } else {
+    chain = _uring_free_chains.back();
+    _uring_free_chains.pop_back();
+  }
+  auto& this_chain = _uring_chains[chain];
+  this_chain = { rule, {}, {}, ops, rule->uring_poll_first, false, ops + rule->uring_poll_first };
+  rule->uring_chain = chain;
+
+  // The reads (or writes) are linked, so each starts only once the previous one has transferred everything it
+  // asked for; a short one ends the chain (the rest complete with ECANCELED). The kernel waits for the fd to be
+  // ready by itself, unless the fd has shown that it answers EAGAIN instead: then a poll goes first.
+  _ring->reserve( ops + 1 );
+  if ( this_chain.poll_first ) {
+    io_uring_sqe& poll = _ring->get_sqe();
+    poll.opcode = IORING_OP_POLL_ADD;
+    poll.fd = rule->fd.fd_num();
+    poll.poll32_events = static_cast<uint16_t>( rule->direction );
+    poll.flags = IOSQE_IO_LINK;
+    poll.user_data = uring_data( UringTag::LinkedPoll, chain );
+  }
+
+  for ( size_t op = 0; op < ops; ++op ) {
+    const auto piece = pieces.at( op );
+    const int region = _uring_fixed ? uring_region_of( piece.data(), piece.size() ) : -1;
+
+    io_uring_sqe& io = _ring->get_sqe();
+    if ( region >= 0 ) {
+      io.opcode = read ? IORING_OP_READ_FIXED : IORING_OP_WRITE_FIXED;
+      io.buf_index = region;
+    } else {
+      io.opcode = read ? IORING_OP_READ : IORING_OP_WRITE;
+    }
+    io.fd = rule->fd.fd_num();
+    io.addr = reinterpret_cast<uint64_t>( piece.data() ); // NOLINT(*-reinterpret-cast)
+    io.len = piece.size();
+    io.off = -1; // the current file position (for a file)
+    io.flags = op + 1 < ops ? IOSQE_IO_LINK : 0;
+    io.user_data = uring_data( UringTag::Operation, static_cast<uint64_t>( chain ) << 3 | op );
+    this_chain.lengths.at( op ) = piece.size();
+  }
+
+  return true;
+}
+
+void EventLoop::complete_uring_chain( const int chain )
+{
+  const UringChain finished = std::exchange( _uring_chains.at( chain ), {} );
+  _uring_free_chains.push_back( chain );
+  auto& this_rule = *finished.rule;
+  this_rule.uring_chain = -1;
+
+  if ( this_rule.cancel_requested or this_rule.fd.closed() ) {
+    return;
+  }
+
+  // the pieces were transferred in order, up to the first that came up short
+  size_t transferred = 0;
+  int failure = 0;
+  bool eof = false;
+  for ( size_t op = 0; op < finished.ops; ++op ) {
+    const int result = finished.results.at( op );
+    if ( result > 0 ) {
+      transferred += result;
+      if ( static_cast<size_t>( result ) == finished.lengths.at( op ) ) {
+        continue;
       }
+    } else if ( result == 0 ) {
+      eof = this_rule.direction == Direction::In;
+    } else if ( result == -EAGAIN ) {
+      this_rule.uring_poll_first = true; // the fd did not wait for readiness; it will from now on
+    } else if ( result != -ECANCELED and result != -EINTR ) {
+      failure = -result;
+    }
+    break;
+  }
+
+  if ( transferred ) {
+    this_rule.done( transferred );
+  }
+
+  if ( failure ) {
+    cerr << "error on file descriptor for rule \"" << _rule_categories.at( this_rule.category_id ).name
+         << "\": " << strerror( failure ) << "\n";
+    this_rule.error();
+  }
+
+  if ( failure or eof ) {
+    // no more reading or writing on this rule
+    this_rule.cancel();
+    this_rule.cancel_requested = true;
+  }
+}
 
-      this_rule.error();
-      this_rule.cancel();
-      it = _fd_rules.erase( it );
+EventLoop::Result EventLoop::wait_uring( const int timeout_ms )
+{
+  // Read and write rules: give the kernel a chain of reads or writes for each one that is interested and has
+  // none in flight, and cancel the ones whose rules are going away.
+  bool something_to_poll = false;
+  for ( const auto& rule : _fd_rules ) {
+    auto& this_rule = *rule;
+    if ( not this_rule.is_io() ) {
       continue;
     }
 
-    const auto poll_ready = static_cast<bool>( this_pollfd.revents & this_pollfd.events );
-    const auto poll_hup = static_cast<bool>( this_pollfd.revents & POLLHUP );
-    if ( poll_hup && ( ( this_pollfd.events && !poll_ready ) or ( this_rule.direction == Direction::Out ) ) ) {
-      // if we asked for the status, and the _only_ condition was a hangup, this FD is defunct:
-      //   - if it was POLLIN and nothing is readable, no more will ever be readable
-      //   - if it was POLLOUT, it will not be writable again
-      // additionally, consider FD defunct if rule will only query for Direction::Out
-      this_rule.cancel();
-      it = _fd_rules.erase( it );
+    const bool finished = this_rule.cancel_requested or this_rule.fd.closed();
+    if ( this_rule.uring_chain >= 0 ) {
+      if ( finished ) {
+        cancel_uring_chain( this_rule.uring_chain );
+      } else {
+        something_to_poll = true;
+      }
       continue;
     }
 
-    if ( poll_ready ) {
-      // we only want to call callback if revents includes the event we asked for
-      const auto count_before = this_rule.service_count();
-      this_rule.callback();
+    this_rule.interested = not finished and this_rule.interest();
+    if ( this_rule.interested and submit_uring_chain( rule ) ) {
+      something_to_poll = true;
+    }
+  }
 
-      if ( count_before == this_rule.service_count() and ( not this_rule.fd.closed() ) and this_rule.interest() ) {
-        throw runtime_error( "EventLoop: busy wait detected: rule \""
-                             + _rule_categories.at( this_rule.category_id ).name
-                             + "\" did not read/write fd and is still interested" );
+  // Every other rule: keep a poll in flight on each watched fd, for the events its rules are interested in
+  // (and errors). A poll completes only once, so it is re-armed after it fires.
+  something_to_poll |= collect_interest( true );
+
+  for ( auto entry_it = _watched_fds.begin(); entry_it != _watched_fds.end(); ) {
+    auto& [fd_num, entry] = *entry_it;
+    const uint64_t poll_data = uring_data( UringTag::Poll, uint64_t { entry.token } << 32 | static_cast<uint32_t>( fd_num ) );
+    if ( entry.rules.empty() ) {
+      if ( entry.registered ) {
+        cancel_uring( poll_data ); // so the kernel lets go of the file
       }
+      entry_it = _watched_fds.erase( entry_it );
+      continue;
+    }
+
+    const bool stale = entry.reset or ( entry.wanted & ~entry.events );
+    if ( entry.registered and stale ) {
+      cancel_uring( poll_data );
+      entry.registered = false;
+    }
+    entry.reset = false;
+    if ( not entry.registered ) {
+      arm_uring_poll( fd_num, entry );
+    }
+    ++entry_it;
+  }
+
+  // quit if there is nothing left to wait for
+  if ( not something_to_poll ) {
+    return Result::Exit;
+  }
 
-      return Result::Success; /* only serve one rule on each iteration */
+  // submit everything, and wait for a completion
+  if ( not _ring->submit_and_wait( timeout_ms ) ) {
+    return Result::Timeout;
+  }
+
+  _ready.clear();
+  _ring->for_each_completion( [&]( const io_uring_cqe& cqe ) {
+    const uint64_t value = cqe.user_data & URING_VALUE_MASK;
+    switch ( static_cast<UringTag>( cqe.user_data >> 62 ) ) {
+      case UringTag::Poll: {
+        const int fd_num = static_cast<int>( value & UINT32_MAX );
+        const auto entry = _watched_fds.find( fd_num );
+        if ( entry != _watched_fds.end() and entry->second.registered and entry->second.token == value >> 32 ) {
+          entry->second.registered = false;
+          if ( cqe.res > 0 ) {
+            _ready.emplace_back( fd_num, static_cast<int16_t>( cqe.res ) );
+          }
+        }
+        break;
+      }
+      case UringTag::Operation: {
+        const auto chain = static_cast<int>( value >> 3 );
+        _uring_chains.at( chain ).results.at( value & 7 ) = cqe.res;
+        if ( --_uring_chains.at( chain ).pending == 0 ) {
+          complete_uring_chain( chain );
+        }
+        break;
+      }
+      case UringTag::LinkedPoll: {
+        const auto chain = static_cast<int>( value );
+        if ( --_uring_chains.at( chain ).pending == 0 ) {
+          complete_uring_chain( chain );
+        }
+        break;
+      }
+      case UringTag::Ignore:
+        break;
     }
+  } );
 
-    ++it; // if we got here, it means we didn't call _fd_rules.erase()
+  // serve the rules on the fds that became ready
+  for ( const auto& [fd_num, revents] : _ready ) {
+    const auto entry = _watched_fds.find( fd_num );
+    if ( entry == _watched_fds.end() ) {
+      continue;
+    }
+    for ( auto it : entry->second.rules ) {
+      if ( ( *it )->cancel_requested or ( *it )->fd.closed() ) {
+        continue;
+      }
+      const auto asked = static_cast<int16_t>( ( *it )->interested ? static_cast<int16_t>( ( *it )->direction ) : 0 );
+      handle_fd_event( it, asked, revents );
+    }
   }
 
   return Result::Success;
 }
 // NOLINTEND(*-signed-bitwise)
-// NOLINTEND(*-cognitive-complexity)
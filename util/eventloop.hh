@@ -1,14 +1,22 @@
 #pragma once
 
+#include <array>
 #include <functional>
 #include <list>
 #include <memory>
+#include <optional>
 #include <ostream>
 #include <poll.h>
+#include <span>
 #include <string_view>
+#include <sys/epoll.h>
+#include <unordered_map>
+#include <vector>
 
 #include "file_descriptor.hh"
 
+class IoUring;
+
 //! Waits for events on file descriptors and executes corresponding callbacks.
 class EventLoop
 {
@@ -20,9 +28,22 @@ public:
     Out = POLLOUT //!< Callback will be triggered when Rule::fd is writable.
   };
 
+  //! How the loop waits for its file descriptors.
+  enum class Backend
+  {
+    Poll,   //!< [poll(2)](\ref man2::poll) on every interested fd, every time (O(rules) in the kernel per wakeup)
+    Epoll,  //!< fds registered once with [epoll(7)](\ref man7::epoll); the kernel only reports the ready ones
+    IoUring //!< polls, and the reads and writes of read/write rules, submitted through [io_uring(7)](\ref
+            //!< man7::io_uring) in batches and done straight into the rules' memory; falls back to Epoll if the
+            //!< kernel does not support it
+  };
+
 private:
   using CallbackT = std::function<void( void )>;
   using InterestT = std::function<bool( void )>;
+  using ReadSpaceT = std::function<std::array<std::span<char>, 2>( void )>;
+  using WriteDataT = std::function<std::array<std::string_view, 2>( void )>;
+  using DoneT = std::function<void( size_t )>;
 
   struct RuleCategory
   {
@@ -45,20 +66,82 @@ private:
     Direction direction; //!< Direction::In for reading from fd, Direction::Out for writing to fd.
     CallbackT cancel;    //!< A callback that is called when the rule is cancelled (e.g. on EOF or hangup)
     CallbackT error;     //!< A callback that is called when the fd has an error before cancellation
+    bool interested {};  //!< What interest() returned when the loop last waited
+
+    // For read and write rules, whose I/O the loop performs itself
+    ReadSpaceT read_space {}; //!< Read rules: where to put the bytes read
+    WriteDataT write_data {}; //!< Write rules: the bytes to write
+    DoneT done {};            //!< Read/write rules: reports the number of bytes read or written
+    int uring_chain { -1 };   //!< IoUring backend: the rule's reads or writes in flight, or -1
+    bool uring_poll_first {}; //!< IoUring backend: the fd answered EAGAIN, so wait for readiness before the I/O
 
     FDRule( BasicRule&& base, FileDescriptor&& s_fd, Direction s_direction, CallbackT s_cancel, CallbackT s_error );
 
     //! Returns the number of times fd has been read or written, depending on the value of Rule::direction.
     //! \details This function is used internally by EventLoop; you will not need to call it
     unsigned int service_count() const;
+
+    bool is_io() const { return static_cast<bool>( done ); }
+  };
+
+  using FDRuleList = std::list<std::shared_ptr<FDRule>>;
+
+  //! Epoll and IoUring backends: the kernel's watch on one fd number, shared by every rule on that fd
+  struct WatchedFD
+  {
+    uint32_t events {};     //!< events currently registered with the kernel
+    uint32_t wanted {};     //!< events the rules are interested in, this iteration
+    bool registered {};     //!< whether the fd has been added to the epoll instance (or has a poll in flight)
+    bool pollable { true }; //!< false for fds epoll refuses (e.g. regular files), which are always ready
+    bool reset {};          //!< a rule's fd was closed; the number may now refer to a different file
+    uint32_t token {};      //!< IoUring: identifies the poll in flight
+    std::vector<FDRuleList::iterator> rules {};
+  };
+
+  //! IoUring backend: the reads (or writes) in flight for a read (or write) rule, linked so the kernel does them
+  //! in order, one after the other, into (or out of) consecutive pieces of the rule's memory
+  struct UringChain
+  {
+    static constexpr size_t MAX_OPS = 4;
+    std::shared_ptr<FDRule> rule {};        //!< kept alive until the kernel is done with the rule's memory
+    std::array<size_t, MAX_OPS> lengths {}; //!< size of each read or write
+    std::array<int, MAX_OPS> results {};    //!< result of each read or write
+    size_t ops {};                          //!< number of reads or writes
+    bool poll_first {};                     //!< whether a readiness wait comes first
+    bool cancelled {};                      //!< whether cancellation has been requested
+    size_t pending {};                      //!< completions still to come
   };
 
   std::vector<RuleCategory> _rule_categories {};
-  std::list<std::shared_ptr<FDRule>> _fd_rules {};
+  FDRuleList _fd_rules {};
   std::list<std::shared_ptr<BasicRule>> _non_fd_rules {};
 
+  Backend _backend;
+  std::unordered_map<int, WatchedFD> _watched_fds {};
+  std::vector<std::pair<int, int16_t>> _ready {}; //!< (fd number, poll-style revents) reported by the last wait
+
+  std::optional<FileDescriptor> _epoll {};
+  std::vector<epoll_event> _epoll_events {};
+
+  static constexpr size_t URING_CHUNK_SIZE = 65536; //!< largest single read or write
+  static constexpr size_t URING_REGIONS = 16;        //!< slots in the fixed-buffer table
+  std::unique_ptr<IoUring> _ring {};
+  std::vector<UringChain> _uring_chains {};
+  std::vector<int> _uring_free_chains {};
+  std::vector<std::span<char>> _uring_regions {}; //!< memory registered with register_memory() (index = slot)
+  bool _uring_fixed {};                           //!< whether the kernel took a fixed-buffer table
+  uint32_t _uring_token {};
+
 public:
-  EventLoop() { _rule_categories.reserve( 64 ); }
+  EventLoop() : EventLoop( Backend::Poll ) {}
+  explicit EventLoop( Backend backend );
+  ~EventLoop();
+
+  EventLoop( const EventLoop& other ) = delete;
+  EventLoop& operator=( const EventLoop& other ) = delete;
+
+  //! The backend in use (Epoll when IoUring was asked for but is not available)
+  Backend backend() const { return _backend; }
 
   //! Returned by each call to EventLoop::wait_next_event.
   enum class Result
@@ -95,15 +178,94 @@ public:
   RuleHandle
   add_rule( size_t category_id, const CallbackT& callback, const InterestT& interest = [] { return true; } );
 
-  //! Calls [poll(2)](\ref man2::poll) and then executes callback for each ready fd.
+  //! A rule whose reads the loop performs itself: it reads into `space()` (e.g. Writer::reserve()) and then
+  //! calls `done` with the number of bytes read. The rule is interested while `interest()` holds and `space()`
+  //! is not empty, and is cancelled at EOF. With the IoUring backend, the kernel reads straight into `space()`
+  //! while the loop waits, so that memory must not be touched until `done` is called, and must outlive the loop.
+  RuleHandle add_read_rule(
+    size_t category_id,
+    FileDescriptor& fd,
+    const ReadSpaceT& space,
+    const DoneT& done,
+    const InterestT& interest = [] { return true; },
+    const CallbackT& cancel = [] {},
+    const CallbackT& error = [] {} );
+
+  //! A rule whose writes the loop performs itself: it writes `data()` (e.g. Reader::peek_all()) and then calls
+  //! `done` with the number of bytes written. The rule is interested while `interest()` holds and `data()` is
+  //! not empty. With the IoUring backend, the kernel writes straight out of `data()` while the loop waits, so
+  //! the bytes must not change (other than by `done`) until `done` is called, and must outlive the loop.
+  RuleHandle add_write_rule(
+    size_t category_id,
+    FileDescriptor& fd,
+    const WriteDataT& data,
+    const DoneT& done,
+    const InterestT& interest = [] { return true; },
+    const CallbackT& cancel = [] {},
+    const CallbackT& error = [] {} );
+
+  //! IoUring backend: lets the kernel keep `region` mapped, so read and write rules whose memory lies in it
+  //! (e.g. a ByteStream's ByteStream::memory()) skip mapping the pages on every read and write. Up to 16
+  //! regions; ignored by the other backends, or if the kernel does not support it.
+  void register_memory( std::span<char> region );
+
+  //! Waits (with poll, epoll or io_uring, depending on the backend) and then executes the callback of a ready fd.
+  //! The IoUring backend runs the callbacks for every completion collected in one wait.
   Result wait_next_event( int timeout_ms );
 
-  // convenience function to add category and rule at the same time
+  // convenience functions to add category and rule at the same time
   template<typename... Targs>
   auto add_rule( const std::string& name, Targs&&... Fargs )
   {
     return add_rule( add_category( name ), std::forward<Targs>( Fargs )... );
   }
+
+  template<typename... Targs>
+  auto add_read_rule( const std::string& name, Targs&&... Fargs )
+  {
+    return add_read_rule( add_category( name ), std::forward<Targs>( Fargs )... );
+  }
+
+  template<typename... Targs>
+  auto add_write_rule( const std::string& name, Targs&&... Fargs )
+  {
+    return add_write_rule( add_category( name ), std::forward<Targs>( Fargs )... );
+  }
+
+private:
+  enum class FDOutcome
+  {
+    Idle,    //!< nothing to do for the rule
+    Removed, //!< the rule was cancelled and erased (the iterator now points past it)
+    Served   //!< the rule's callback ran
+  };
+
+  //! Serves the non-fd rules; returns true if one fired.
+  bool serve_non_fd_rules();
+
+  //! Erases the rule if it was cancelled or its fd is done; returns true if it was erased.
+  bool retire_fd_rule( FDRuleList::iterator& it );
+
+  //! Acts on what the kernel reported for a rule's fd (`asked` is the event the rule waited for, or 0).
+  FDOutcome handle_fd_event( FDRuleList::iterator& it, int16_t asked, int16_t revents );
+
+  //! Epoll and IoUring backends: retires finished rules and works out the events each watched fd needs.
+  //! Read/write rules are left out if `skip_io`. Returns whether any rule is interested.
+  bool collect_interest( bool skip_io );
+
+  Result wait_poll( int timeout_ms );
+
+  Result wait_epoll( int timeout_ms );
+  void epoll_update( int fd_num, WatchedFD& entry );
+
+  Result wait_uring( int timeout_ms );
+  void setup_uring();
+  void arm_uring_poll( int fd_num, WatchedFD& entry );
+  void cancel_uring( uint64_t user_data );
+  void cancel_uring_chain( int chain );
+  bool submit_uring_chain( const std::shared_ptr<FDRule>& rule );
+  void complete_uring_chain( int chain );
+  int uring_region_of( const char* data, size_t size ) const;
 };
 
 using Direction = EventLoop::Direction;
@@ -6,6 +6,7 @@
 #include <fcntl.h>
 #include <iostream>
 #include <stdexcept>
+#include <sys/socket.h>
 #include <sys/stat.h>
 #include <sys/types.h>
 #include <sys/uio.h>
@@ -151,6 +152,43 @@ void FileDescriptor::read( vector<string>& buffers )
   }
 }
 
+size_t FileDescriptor::read( span<const span<char>> buffers )
+{
+  vector<iovec> iovecs;
+  iovecs.reserve( buffers.size() );
+  size_t total_size = 0;
+  for ( const auto x : buffers ) {
+    if ( not x.empty() ) {
+      iovecs.push_back( { x.data(), x.size() } );
+      total_size += x.size();
+    }
+  }
+
+  if ( iovecs.empty() ) {
+    return 0;
+  }
+
+  const ssize_t bytes_read = ::readv( fd_num(), iovecs.data(), static_cast<int>( iovecs.size() ) );
+  if ( bytes_read < 0 ) {
+    if ( internal_fd_->non_blocking_ and ( errno == EAGAIN or errno == EINPROGRESS ) ) {
+      return 0;
+    }
+    throw unix_error { "read" };
+  }
+
+  register_read();
+
+  if ( bytes_read == 0 ) {
+    internal_fd_->eof_ = true;
+  }
+
+  if ( bytes_read > static_cast<ssize_t>( total_size ) ) {
+    throw runtime_error( "read() read more than requested" );
+  }
+
+  return bytes_read;
+}
+
 size_t FileDescriptor::write( string_view buffer )
 {
   return write( vector<string_view> { buffer } );
@@ -166,7 +204,22 @@ size_t FileDescriptor::write( const vector<std::string>& buffers )
   return write( views );
 }
 
+size_t FileDescriptor::write( const BufferList& buffers )
+{
+  vector<string_view> views;
+  views.reserve( buffers.buffers().size() );
+  for ( const auto& x : buffers ) {
+    views.push_back( x );
+  }
+  return write( views );
+}
+
 size_t FileDescriptor::write( const vector<string_view>& buffers )
+{
+  return write( span<const string_view> { buffers } );
+}
+
+size_t FileDescriptor::write( span<const string_view> buffers )
 {
   vector<iovec> iovecs;
   iovecs.reserve( buffers.size() );
@@ -191,6 +244,41 @@ size_t FileDescriptor::write( const vector<string_view>& buffers )
   return bytes_written;
 }
 
+size_t FileDescriptor::write_datagrams( span<const BufferList> datagrams )
+{
+  size_t num_iovecs = 0;
+  for ( const auto& dgram : datagrams ) {
+    num_iovecs += dgram.buffers().size();
+  }
+
+  vector<iovec> iovecs;
+  iovecs.reserve( num_iovecs );
+  vector<mmsghdr> headers( datagrams.size() );
+  for ( size_t i = 0; i < datagrams.size(); ++i ) {
+    headers[i].msg_hdr.msg_iov = iovecs.data() + iovecs.size();
+    headers[i].msg_hdr.msg_iovlen = datagrams[i].buffers().size();
+    for ( const auto& x : datagrams[i] ) {
+      iovecs.push_back( { const_cast<char*>( x.data() ), x.size() } ); // NOLINT(*-const-cast)
+    }
+  }
+
+  // sendmmsg may stop early (e.g. when the socket buffer fills); keep going until everything is sent,
+  // or until a non-blocking socket would block
+  size_t sent = 0;
+  while ( sent < headers.size() ) {
+    const int n = CheckSystemCall(
+      "sendmmsg",
+      ::sendmmsg( fd_num(), headers.data() + sent, static_cast<unsigned int>( headers.size() - sent ), 0 ) );
+    register_write();
+    if ( n == 0 ) {
+      break;
+    }
+    sent += n;
+  }
+
+  return sent;
+}
+
 void FileDescriptor::set_blocking( bool blocking )
 {
   int flags = CheckSystemCall( "fcntl", fcntl( fd_num(), F_GETFL ) ); // NOLINT(*-vararg)
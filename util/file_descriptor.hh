@@ -1,8 +1,11 @@
 #pragma once
 
+#include "buffer.hh"
+
 #include <cstddef>
 #include <limits>
 #include <memory>
+#include <span>
 #include <vector>
 
 // A reference-counted handle to a file descriptor
@@ -65,11 +68,21 @@ public:
   void read( std::string& buffer );
   void read( std::vector<std::string>& buffers );
 
+  // Read directly into caller-owned memory (e.g. space reserved inside a ByteStream)
+  // returns number of bytes read
+  size_t read( std::span<const std::span<char>> buffers );
+
   // Attempt to write a buffer
   // returns number of bytes written
   size_t write( std::string_view buffer );
   size_t write( const std::vector<std::string_view>& buffers );
+  size_t write( std::span<const std::string_view> buffers ); // gather-write all buffers with one writev
   size_t write( const std::vector<std::string>& buffers );
+  size_t write( const BufferList& buffers );
+
+  // Send each BufferList as its own datagram, all with one sendmmsg (the descriptor must be a datagram socket)
+  // returns number of datagrams sent (fewer than requested only if a non-blocking socket would block)
+  size_t write_datagrams( std::span<const BufferList> datagrams );
 
   // Close the underlying file descriptor
   void close() { internal_fd_->close(); }
@@ -0,0 +1,159 @@
+#pragma once
+
+#include "parser.hh"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+// Compile-time descriptions of fixed-layout wire headers.
+//
+// A header is described once, as a `wire::Layout` of fields given by their bit offset from the start of
+// the header (in network order, i.e. bit 0 is the most significant bit of the first byte) and their width.
+// The layout then generates the parser and serializer: the whole header is decoded from (or encoded into)
+// one contiguous block of memory, and every field access compiles to fixed-offset loads, shifts and masks.
+//
+// For example, a UDP header would be
+//
+//   using UDPLayout = wire::Layout<8, wire::Field<0, 16>, wire::Field<16, 16>, wire::Field<32, 16>,
+//                                     wire::Field<48, 16>>;
+//
+// and parsed with `UDPLayout::parse( parser, src_port, dst_port, length, cksum )`.
+namespace wire {
+
+// An unsigned big-endian field of `Width` bits (1 to 32), e.g. a whole integer, a bitfield or a flag
+template<size_t BitOffset, size_t Width>
+struct Field
+{
+  static_assert( Width >= 1 and Width <= 32, "use ByteArray for fields wider than 32 bits" );
+
+  static constexpr size_t BIT_OFFSET = BitOffset;
+  static constexpr size_t BITS = Width;
+
+  using type = std::conditional_t<Width <= 8, uint8_t, std::conditional_t<Width <= 16, uint16_t, uint32_t>>;
+
+private:
+  static constexpr size_t FIRST_BYTE = BitOffset / 8;
+  static constexpr size_t NUM_BYTES = ( BitOffset % 8 + Width + 7 ) / 8;
+  static constexpr size_t SHIFT = NUM_BYTES * 8 - BitOffset % 8 - Width;
+  static constexpr uint64_t MASK = ( uint64_t { 1 } << Width ) - 1;
+
+  // The bytes that hold this field, as one big-endian word
+  static uint64_t load_word( const char* header )
+  {
+    uint64_t word = 0;
+    for ( size_t i = 0; i < NUM_BYTES; ++i ) {
+      word = ( word << 8 ) | static_cast<uint8_t>( header[FIRST_BYTE + i] );
+    }
+    return word;
+  }
+
+  static void store_word( char* header, uint64_t word )
+  {
+    for ( size_t i = 0; i < NUM_BYTES; ++i ) {
+      header[FIRST_BYTE + NUM_BYTES - 1 - i] = static_cast<char>( word & 0xff );
+      word >>= 8;
+    }
+  }
+
+public:
+  static type get( const char* header ) { return static_cast<type>( ( load_word( header ) >> SHIFT ) & MASK ); }
+
+  // Write the field, leaving the other bits of the bytes it shares with its neighbours untouched
+  static void set( char* header, uint64_t value )
+  {
+    const uint64_t word = ( load_word( header ) & ~( MASK << SHIFT ) ) | ( ( value & MASK ) << SHIFT );
+    store_word( header, word );
+  }
+
+  template<class T>
+  static void load( const char* header, T& out )
+  {
+    out = static_cast<T>( get( header ) );
+  }
+
+  template<class T>
+  static void store( char* header, const T& in )
+  {
+    set( header, static_cast<uint64_t>( in ) );
+  }
+};
+
+// A byte-aligned run of `Count` raw bytes (e.g. an Ethernet address)
+template<size_t BitOffset, size_t Count>
+struct ByteArray
+{
+  static_assert( BitOffset % 8 == 0, "ByteArray must start on a byte boundary" );
+
+  static constexpr size_t BIT_OFFSET = BitOffset;
+  static constexpr size_t BITS = Count * 8;
+
+  template<class T>
+  static void load( const char* header, T& out )
+  {
+    static_assert( sizeof( out ) == Count );
+    std::memcpy( out.data(), header + BitOffset / 8, Count );
+  }
+
+  template<class T>
+  static void store( char* header, const T& in )
+  {
+    static_assert( sizeof( in ) == Count );
+    std::memcpy( header + BitOffset / 8, in.data(), Count );
+  }
+};
+
+// A fixed-length header made of `Fields`, listed in order of increasing offset.
+// Bits not covered by any field are written as zero and ignored when parsing.
+template<size_t Length, class... Fields>
+class Layout
+{
+  static constexpr bool well_formed()
+  {
+    constexpr std::array<size_t, sizeof...( Fields )> begins { Fields::BIT_OFFSET... };
+    constexpr std::array<size_t, sizeof...( Fields )> ends { ( Fields::BIT_OFFSET + Fields::BITS )... };
+    for ( size_t i = 0; i < begins.size(); ++i ) {
+      if ( ends[i] > Length * 8 or ( i > 0 and begins[i] < ends[i - 1] ) ) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  static_assert( well_formed(), "header fields must be in order, must not overlap, and must fit in the header" );
+
+public:
+  static constexpr size_t LENGTH = Length;
+
+  // Decode every field from `header` (which holds at least LENGTH bytes), one output per field
+  template<class... Ts>
+  static void load( const char* header, Ts&... out )
+  {
+    static_assert( sizeof...( Ts ) == sizeof...( Fields ) );
+    ( Fields::load( header, out ), ... );
+  }
+
+  // Encode every field into `header` (which holds at least LENGTH zeroed bytes), one input per field
+  template<class... Ts>
+  static void store( char* header, const Ts&... in )
+  {
+    static_assert( sizeof...( Ts ) == sizeof...( Fields ) );
+    ( Fields::store( header, in ), ... );
+  }
+
+  template<class... Ts>
+  static void parse( Parser& parser, Ts&... out )
+  {
+    parser.fixed<Length>( [&]( const char* header ) { load( header, out... ); } );
+  }
+
+  template<class... Ts>
+  static void serialize( Serializer& serializer, const Ts&... in )
+  {
+    serializer.fixed<Length>( [&]( char* header ) { store( header, in... ); } );
+  }
+};
+
+} // namespace wire
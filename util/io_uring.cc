@@ -0,0 +1,151 @@
+#include "io_uring.hh"
+#include "exception.hh"
+
+#include <algorithm>
+#include <csignal>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+using namespace std;
+
+namespace {
+
+int setup( const unsigned entries, io_uring_params& params )
+{
+  return CheckSystemCall( "io_uring_setup",
+                          static_cast<int>( syscall( __NR_io_uring_setup, entries, &params ) ) ); // NOLINT(*-vararg)
+}
+
+template<typename T>
+T* field( const char* ring, const uint32_t offset )
+{
+  return reinterpret_cast<T*>( const_cast<char*>( ring ) + offset ); // NOLINT(*-reinterpret-cast, *-const-cast)
+}
+
+} // namespace
+
+IoUring::Mapping::Mapping( const FileDescriptor& fd, const size_t length, const uint64_t offset )
+  : addr_( mmap( nullptr, length, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd.fd_num(), offset ) )
+  , length_( length )
+{
+  if ( addr_ == MAP_FAILED ) {
+    throw unix_error { "mmap io_uring" };
+  }
+}
+
+IoUring::Mapping::~Mapping()
+{
+  munmap( addr_, length_ );
+}
+
+IoUring::IoUring( const unsigned entries )
+  : fd_( setup( entries, params_ ) )
+  , sq_ring_( fd_, params_.sq_off.array + params_.sq_entries * sizeof( unsigned ), IORING_OFF_SQ_RING )
+  , cq_ring_( fd_, params_.cq_off.cqes + params_.cq_entries * sizeof( io_uring_cqe ), IORING_OFF_CQ_RING )
+  , sqes_mapping_( fd_, params_.sq_entries * sizeof( io_uring_sqe ), IORING_OFF_SQES )
+  , sq_head_( field<unsigned>( sq_ring_.data(), params_.sq_off.head ) )
+  , sq_tail_( field<unsigned>( sq_ring_.data(), params_.sq_off.tail ) )
+  , sq_mask_( field<unsigned>( sq_ring_.data(), params_.sq_off.ring_mask ) )
+  , sq_array_( field<unsigned>( sq_ring_.data(), params_.sq_off.array ) )
+  , sqes_( field<io_uring_sqe>( sqes_mapping_.data(), 0 ) )
+  , cq_head_( field<unsigned>( cq_ring_.data(), params_.cq_off.head ) )
+  , cq_tail_( field<unsigned>( cq_ring_.data(), params_.cq_off.tail ) )
+  , cq_mask_( field<unsigned>( cq_ring_.data(), params_.cq_off.ring_mask ) )
+  , cqes_( field<io_uring_cqe>( cq_ring_.data(), params_.cq_off.cqes ) )
+  , sqe_tail_( *sq_tail_ )
+{
+  // waiting with a timeout needs IORING_FEAT_EXT_ARG (Linux 5.11), and reads and writes at the current file
+  // position (offset -1) need IORING_FEAT_RW_CUR_POS
+  if ( not( params_.features & IORING_FEAT_EXT_ARG ) or not( params_.features & IORING_FEAT_RW_CUR_POS ) ) {
+    throw runtime_error( "io_uring: kernel is too old" );
+  }
+}
+
+void IoUring::reserve( const unsigned n )
+{
+  const unsigned head = atomic_ref<unsigned>( *sq_head_ ).load( memory_order_acquire );
+  if ( n > params_.sq_entries ) {
+    throw runtime_error( "io_uring: cannot reserve more entries than the submission queue holds" );
+  }
+  if ( sqe_tail_ - head + n > params_.sq_entries ) {
+    const int ret = enter( 0, 0 );
+    if ( ret < 0 ) {
+      throw unix_error { "io_uring_enter", -ret };
+    }
+  }
+}
+
+io_uring_sqe& IoUring::get_sqe()
+{
+  reserve( 1 );
+
+  const unsigned index = sqe_tail_ & *sq_mask_;
+  sqes_[index] = {};
+  sq_array_[index] = index;
+  ++sqe_tail_;
+  return sqes_[index];
+}
+
+int IoUring::enter( const unsigned min_complete, const int timeout_ms )
+{
+  // publish the queued entries (the kernel only reads them during io_uring_enter)
+  atomic_ref<unsigned>( *sq_tail_ ).store( sqe_tail_, memory_order_release );
+  const unsigned to_submit = sqe_tail_ - atomic_ref<unsigned>( *sq_head_ ).load( memory_order_acquire );
+
+  __kernel_timespec ts { timeout_ms / 1000, static_cast<long long>( timeout_ms % 1000 ) * 1000000 };
+  io_uring_getevents_arg arg {};
+  arg.sigmask_sz = _NSIG / 8;
+  arg.ts = timeout_ms >= 0 ? reinterpret_cast<uint64_t>( &ts ) : 0; // NOLINT(*-reinterpret-cast)
+
+  const unsigned flags = IORING_ENTER_EXT_ARG | ( min_complete ? IORING_ENTER_GETEVENTS : 0 );
+  const long ret = syscall( // NOLINT(*-vararg)
+    __NR_io_uring_enter,
+    fd_.fd_num(),
+    to_submit,
+    min_complete,
+    flags,
+    &arg,
+    sizeof( arg ) );
+  return ret < 0 ? -errno : static_cast<int>( ret );
+}
+
+bool IoUring::submit_and_wait( const int timeout_ms )
+{
+  const int ret = enter( timeout_ms == 0 ? 0 : 1, timeout_ms );
+  if ( ret < 0 and ret != -ETIME and ret != -EINTR ) {
+    throw unix_error { "io_uring_enter", -ret };
+  }
+
+  return *cq_head_ != atomic_ref<unsigned>( *cq_tail_ ).load( memory_order_acquire );
+}
+
+void IoUring::register_buffer_table( const unsigned slots )
+{
+  io_uring_rsrc_register reg {};
+  reg.nr = slots;
+  reg.flags = IORING_RSRC_REGISTER_SPARSE;
+  CheckSystemCall( "io_uring_register",
+                   static_cast<int>( syscall( // NOLINT(*-vararg)
+                     __NR_io_uring_register,
+                     fd_.fd_num(),
+                     IORING_REGISTER_BUFFERS2,
+                     &reg,
+                     sizeof( reg ) ) ) );
+}
+
+void IoUring::update_buffer( const unsigned slot, const iovec& buffer )
+{
+  io_uring_rsrc_update2 update {};
+  update.offset = slot;
+  update.data = reinterpret_cast<uint64_t>( &buffer ); // NOLINT(*-reinterpret-cast)
+  update.nr = 1;
+  CheckSystemCall( "io_uring_register",
+                   static_cast<int>( syscall( // NOLINT(*-vararg)
+                     __NR_io_uring_register,
+                     fd_.fd_num(),
+                     IORING_REGISTER_BUFFERS_UPDATE,
+                     &update,
+                     sizeof( update ) ) ) );
+}
@@ -0,0 +1,92 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <linux/io_uring.h>
+#include <sys/uio.h>
+
+#include "file_descriptor.hh"
+
+//! A minimal [io_uring(7)](\ref man7::io_uring) instance, driven directly through the system calls: the
+//! program queues requests (io_uring_sqe) in a submission ring shared with the kernel, and the kernel posts
+//! their results (io_uring_cqe) to a completion ring. Any number of requests are submitted, and completions
+//! waited for, with a single io_uring_enter().
+class IoUring
+{
+public:
+  //! Throws if the kernel has no usable io_uring (too old, or disabled, e.g. by kernel.io_uring_disabled)
+  explicit IoUring( unsigned entries );
+
+  // The rings are mapped at fixed addresses, so an IoUring cannot be copied or moved
+  IoUring( const IoUring& other ) = delete;
+  IoUring& operator=( const IoUring& other ) = delete;
+
+  //! A zeroed submission queue entry to fill in. Entries are handed to the kernel by the next submit_and_wait().
+  io_uring_sqe& get_sqe();
+
+  //! Make sure the next `n` calls to get_sqe() go into the same submission (so they can be linked)
+  void reserve( unsigned n );
+
+  //! Submit the queued entries, then wait up to `timeout_ms` (-1: forever, 0: not at all) for at least one
+  //! completion. Returns whether any completions are available.
+  bool submit_and_wait( int timeout_ms );
+
+  //! Consume the available completions, calling `f( cqe )` on each. `f` may queue more submissions.
+  template<class F>
+  size_t for_each_completion( F&& f )
+  {
+    size_t ret = 0;
+    const unsigned tail = std::atomic_ref<unsigned>( *cq_tail_ ).load( std::memory_order_acquire );
+    for ( unsigned head = *cq_head_; head != tail; ++head, ++ret ) {
+      const io_uring_cqe cqe = cqes_[head & *cq_mask_];
+      std::atomic_ref<unsigned>( *cq_head_ ).store( head + 1, std::memory_order_release );
+      f( cqe );
+    }
+    return ret;
+  }
+
+  //! Set up an empty table of `slots` fixed buffers (for IORING_OP_READ_FIXED and IORING_OP_WRITE_FIXED), to be
+  //! filled in with update_buffer(). Needs Linux 5.19; throws if the kernel refuses.
+  void register_buffer_table( unsigned slots );
+
+  //! Register `buffer` as fixed buffer `slot` (its buf_index)
+  void update_buffer( unsigned slot, const iovec& buffer );
+
+private:
+  //! A region of the ring shared with the kernel
+  class Mapping
+  {
+    void* addr_;
+    size_t length_;
+
+  public:
+    Mapping( const FileDescriptor& fd, size_t length, uint64_t offset );
+    ~Mapping();
+    char* data() const { return static_cast<char*>( addr_ ); }
+
+    Mapping( const Mapping& other ) = delete;
+    Mapping& operator=( const Mapping& other ) = delete;
+  };
+
+  io_uring_params params_ {};
+  FileDescriptor fd_;
+  Mapping sq_ring_;
+  Mapping cq_ring_; // (the same memory as sq_ring_ on kernels with IORING_FEAT_SINGLE_MMAP)
+  Mapping sqes_mapping_;
+
+  unsigned* sq_head_;
+  unsigned* sq_tail_;
+  unsigned* sq_mask_;
+  unsigned* sq_array_;
+  io_uring_sqe* sqes_;
+  unsigned* cq_head_;
+  unsigned* cq_tail_;
+  unsigned* cq_mask_;
+  io_uring_cqe* cqes_;
+
+  unsigned sqe_tail_ {}; // entries handed out by get_sqe(); published to the kernel by enter()
+
+  // io_uring_enter(): submit everything queued, and wait for `min_complete` completions; returns -errno on error
+  int enter( unsigned min_complete, int timeout_ms );
+};
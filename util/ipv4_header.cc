@@ -1,5 +1,6 @@
 #include "ipv4_header.hh"
 #include "checksum.hh"
+#include "header_layout.hh"
 
 #include <arpa/inet.h>
 #include <array>
@@ -8,28 +9,42 @@
 
 using namespace std;
 
+namespace {
+// IPv4 header fields (see the diagram in ipv4_header.hh), as bit offsets from the start of the header
+using Version = wire::Field<0, 4>;
+using HeaderLength = wire::Field<4, 4>;
+using TypeOfService = wire::Field<8, 8>;
+using TotalLength = wire::Field<16, 16>;
+using Identification = wire::Field<32, 16>;
+using DontFragment = wire::Field<49, 1>;
+using MoreFragments = wire::Field<50, 1>;
+using FragmentOffset = wire::Field<51, 13>;
+using TimeToLive = wire::Field<64, 8>;
+using Protocol = wire::Field<72, 8>;
+using Checksum = wire::Field<80, 16>;
+using Source = wire::Field<96, 32>;
+using Destination = wire::Field<128, 32>;
+
+using Layout = wire::Layout<IPv4Header::LENGTH,
+                            Version,
+                            HeaderLength,
+                            TypeOfService,
+                            TotalLength,
+                            Identification,
+                            DontFragment,
+                            MoreFragments,
+                            FragmentOffset,
+                            TimeToLive,
+                            Protocol,
+                            Checksum,
+                            Source,
+                            Destination>;
+} // namespace
+
 // Parse from string.
 void IPv4Header::parse( Parser& parser )
 {
-  uint8_t first_byte {};
-  parser.integer( first_byte );
-  ver = first_byte >> 4;    // version
-  hlen = first_byte & 0x0f; // header length
-  parser.integer( tos );    // type of service
-  parser.integer( len );
-  parser.integer( id );
-
-  uint16_t fo_val {};
-  parser.integer( fo_val );
-  df = static_cast<bool>( fo_val & 0x4000 ); // don't fragment
-  mf = static_cast<bool>( fo_val & 0x2000 ); // more fragments
-  offset = fo_val & 0x1fff;                  // offset
-
-  parser.integer( ttl );
-  parser.integer( proto );
-  parser.integer( cksum );
-  parser.integer( src );
-  parser.integer( dst );
+  Layout::parse( parser, ver, hlen, tos, len, id, df, mf, offset, ttl, proto, cksum, src, dst );
 
   if ( ver != 4 ) {
     parser.set_error();
@@ -61,22 +76,7 @@ void IPv4Header::serialize( Serializer& serializer ) const
     throw runtime_error( "wrong IP version" );
   }
 
-  const uint8_t first_byte = ( static_cast<uint32_t>( ver ) << 4 ) | ( hlen & 0xfU );
-  serializer.integer( first_byte ); // version and header length
-  serializer.integer( tos );
-  serializer.integer( len );
-  serializer.integer( id );
-
-  const uint16_t fo_val = ( df ? 0x4000U : 0 ) | ( mf ? 0x2000U : 0 ) | ( offset & 0x1fffU );
-  serializer.integer( fo_val );
-
-  serializer.integer( ttl );
-  serializer.integer( proto );
-
-  serializer.integer( cksum );
-
-  serializer.integer( src );
-  serializer.integer( dst );
+  Layout::serialize( serializer, ver, hlen, tos, len, id, df, mf, offset, ttl, proto, cksum, src, dst );
 }
 
 uint16_t IPv4Header::payload_length() const
@@ -106,16 +106,25 @@ uint32_t IPv4Header::pseudo_checksum() const
 
 void IPv4Header::compute_checksum()
 {
-  cksum = 0;
-  Serializer s;
-  serialize( s );
+  array<char, LENGTH> header {};
+  Layout::store( header.data(), ver, hlen, tos, len, id, df, mf, offset, ttl, proto, cksum, src, dst );
+  Checksum::set( header.data(), 0 );
 
   // calculate checksum -- taken over header only
   InternetChecksum check;
-  check.add( s.output() );
+  check.add( string_view { header.data(), header.size() } );
   cksum = check.value();
 }
 
+void IPv4Header::decrement_ttl()
+{
+  // TTL shares a 16-bit word of the header with the protocol field
+  const uint16_t old_word = static_cast<uint16_t>( ttl << 8 | proto );
+  --ttl;
+  const uint16_t new_word = static_cast<uint16_t>( ttl << 8 | proto );
+  cksum = InternetChecksum::adjust( cksum, old_word, new_word );
+}
+
 std::string IPv4Header::to_string() const
 {
   stringstream ss {};
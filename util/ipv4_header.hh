@@ -57,6 +57,9 @@ struct IPv4Header
   // Set checksum to correct value
   void compute_checksum();
 
+  // Decrement the TTL (e.g. when forwarding), adjusting the checksum incrementally instead of recomputing it
+  void decrement_ttl();
+
   // Return a string containing a header in human-readable format
   std::string to_string() const;
 
@@ -0,0 +1,90 @@
+#include "mirrored_buffer.hh"
+#include "exception.hh"
+#include "file_descriptor.hh"
+
+#include <algorithm>
+#include <cerrno>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <unistd.h>
+#include <utility>
+
+using namespace std;
+
+size_t MirroredBuffer::page_size()
+{
+  static const size_t size = CheckSystemCall( "sysconf", static_cast<int>( sysconf( _SC_PAGESIZE ) ) );
+  return size;
+}
+
+//! \param[in] size is the length of the buffer, which must be a nonzero multiple of page_size()
+MirroredBuffer::MirroredBuffer( size_t size )
+{
+  if ( size == 0 or size % page_size() ) {
+    throw runtime_error( "MirroredBuffer size must be a nonzero multiple of the page size" );
+  }
+
+  // the memory object that will be mapped twice (closed at the end of this scope; the mappings keep it alive)
+  const FileDescriptor memfd { CheckSystemCall( "memfd_create", memfd_create( "minnow-ring", MFD_CLOEXEC ) ) };
+  CheckSystemCall( "ftruncate", ftruncate( memfd.fd_num(), static_cast<off_t>( size ) ) );
+
+  // reserve a contiguous range of address space for both copies
+  void* const base = mmap( nullptr, 2 * size, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0 );
+  if ( base == MAP_FAILED ) {
+    throw unix_error { "mmap" };
+  }
+  data_ = static_cast<char*>( base );
+  size_ = size;
+
+  // map the same pages into each half
+  for ( char* const half : { data_, data_ + size } ) {
+    if ( mmap( half, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, memfd.fd_num(), 0 ) == MAP_FAILED ) {
+      const int saved_errno = errno;
+      unmap();
+      throw unix_error { "mmap", saved_errno };
+    }
+  }
+}
+
+void MirroredBuffer::unmap()
+{
+  if ( data_ ) {
+    munmap( data_, 2 * size_ );
+  }
+  data_ = nullptr;
+  size_ = 0;
+}
+
+MirroredBuffer::~MirroredBuffer()
+{
+  unmap();
+}
+
+MirroredBuffer::MirroredBuffer( const MirroredBuffer& other ) : MirroredBuffer()
+{
+  *this = other;
+}
+
+MirroredBuffer& MirroredBuffer::operator=( const MirroredBuffer& other )
+{
+  if ( this != &other ) {
+    MirroredBuffer copy = other.empty() ? MirroredBuffer {} : MirroredBuffer { other.size_ };
+    copy_n( other.data_, other.size_, copy.data_ );
+    *this = move( copy );
+  }
+  return *this;
+}
+
+MirroredBuffer::MirroredBuffer( MirroredBuffer&& other ) noexcept
+  : data_( exchange( other.data_, nullptr ) ), size_( exchange( other.size_, 0 ) )
+{}
+
+MirroredBuffer& MirroredBuffer::operator=( MirroredBuffer&& other ) noexcept
+{
+  if ( this != &other ) {
+    unmap();
+    data_ = exchange( other.data_, nullptr );
+    size_ = exchange( other.size_, 0 );
+  }
+  return *this;
+}
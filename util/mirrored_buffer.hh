@@ -0,0 +1,32 @@
+#pragma once
+
+#include <cstddef>
+
+//! A ring-buffer backing store whose pages are mapped twice, back to back, in virtual memory.
+//! Byte `i` of the buffer is also visible at `i + size()`, so any run of up to size() bytes starting
+//! anywhere in the first half can be accessed as one contiguous span, even if it wraps around the end.
+class MirroredBuffer
+{
+  char* data_ {};  // start of the 2 * size_ byte mapping
+  size_t size_ {}; // length of the buffer (one mapping)
+
+  void unmap();
+
+public:
+  //! The size of a MirroredBuffer must be a multiple of page_size()
+  static size_t page_size();
+
+  MirroredBuffer() = default;
+  explicit MirroredBuffer( size_t size );
+  ~MirroredBuffer();
+
+  MirroredBuffer( const MirroredBuffer& other );            // allocates a new mapping and copies the contents
+  MirroredBuffer& operator=( const MirroredBuffer& other ); // allocates a new mapping and copies the contents
+  MirroredBuffer( MirroredBuffer&& other ) noexcept;
+  MirroredBuffer& operator=( MirroredBuffer&& other ) noexcept;
+
+  char* data() { return data_; }
+  const char* data() const { return data_; }
+  size_t size() const { return size_; }
+  bool empty() const { return size_ == 0; }
+};
@@ -1,116 +1,41 @@
 #pragma once
 
+#include "buffer.hh"
+
 #include <algorithm>
+#include <array>
+#include <bit>
 #include <concepts>
 #include <cstdint>
 #include <cstring>
-#include <deque>
-#include <numeric>
 #include <span>
-#include <stdexcept>
 #include <string>
 #include <string_view>
 #include <vector>
 
-class Parser
+// Load a big-endian integer from (possibly unaligned) memory
+template<std::unsigned_integral T>
+T load_big_endian( const char* p )
 {
-  class BufferList
-  {
-    uint64_t size_ {};
-    std::deque<std::string> buffer_ {};
-    uint64_t skip_ {};
-
-  public:
-    explicit BufferList( const std::vector<std::string>& buffers )
-    {
-      for ( const auto& x : buffers ) {
-        append( x );
-      }
-    }
-
-    uint64_t size() const { return size_; }
-    uint64_t serialized_length() const { return size(); }
-    bool empty() const { return size_ == 0; }
-
-    std::string_view peek() const
-    {
-      if ( buffer_.empty() ) {
-        throw std::runtime_error( "peek on empty BufferList" );
-      }
-      return std::string_view { buffer_.front() }.substr( skip_ );
-    }
-
-    void remove_prefix( uint64_t len )
-    {
-      while ( len and not buffer_.empty() ) {
-        const uint64_t to_pop_now = std::min( len, peek().size() );
-        skip_ += to_pop_now;
-        len -= to_pop_now;
-        size_ -= to_pop_now;
-        if ( skip_ == buffer_.front().size() ) {
-          buffer_.pop_front();
-          skip_ = 0;
-        }
-      }
-    }
-
-    void dump_all( std::vector<std::string>& out )
-    {
-      out.clear();
-      if ( empty() ) {
-        return;
-      }
-      std::string first_str = std::move( buffer_.front() );
-      if ( skip_ ) {
-        first_str = first_str.substr( skip_ );
-      }
-      out.emplace_back( std::move( first_str ) );
-      buffer_.pop_front();
-      for ( auto&& x : buffer_ ) {
-        out.emplace_back( std::move( x ) );
-      }
-    }
-
-    void dump_all( std::string& out )
-    {
-      std::vector<std::string> concat;
-      dump_all( concat );
-      if ( concat.size() == 1 ) {
-        out = std::move( concat.front() );
-        return;
-      }
-
-      out.clear();
-      for ( const auto& s : concat ) {
-        out.append( s );
-      }
-    }
-
-    std::vector<std::string_view> buffer() const
-    {
-      if ( empty() ) {
-        return {};
-      }
-      std::vector<std::string_view> ret;
-      ret.reserve( buffer_.size() );
-      auto tmp_skip = skip_;
-      for ( const auto& x : buffer_ ) {
-        ret.push_back( std::string_view { x }.substr( tmp_skip ) );
-        tmp_skip = 0;
-      }
-      return ret;
-    }
-
-    void append( std::string str )
-    {
-      size_ += str.size();
-      buffer_.push_back( std::move( str ) );
-    }
-  };
+  T val {};
+  std::memcpy( &val, p, sizeof( T ) );
+  if constexpr ( std::endian::native == std::endian::little and sizeof( T ) == 2 ) {
+    val = __builtin_bswap16( val );
+  } else if constexpr ( std::endian::native == std::endian::little and sizeof( T ) == 4 ) {
+    val = __builtin_bswap32( val );
+  } else if constexpr ( std::endian::native == std::endian::little and sizeof( T ) == 8 ) {
+    val = __builtin_bswap64( val );
+  }
+  return val;
+}
 
+class Parser
+{
   BufferList input_;
   bool error_ {};
 
+  std::string_view peek() const { return input_.buffers().front(); }
+
   void check_size( const size_t size )
   {
     if ( size > input_.size() ) {
@@ -119,7 +44,7 @@ class Parser
   }
 
 public:
-  explicit Parser( const std::vector<std::string>& input ) : input_( input ) {}
+  explicit Parser( BufferList input ) : input_( std::move( input ) ) {}
 
   const BufferList& input() const { return input_; }
 
@@ -135,18 +60,41 @@ public:
       return;
     }
 
-    if constexpr ( sizeof( T ) == 1 ) {
-      out = static_cast<uint8_t>( input_.peek().front() );
+    // fast path: the whole integer is in the current buffer
+    if ( peek().size() >= sizeof( T ) ) {
+      out = load_big_endian<T>( peek().data() );
+      input_.remove_prefix( sizeof( T ) );
+      return;
+    }
+
+    // slow path: the integer straddles a buffer boundary
+    out = static_cast<T>( 0 );
+    for ( size_t i = 0; i < sizeof( T ); i++ ) {
+      out <<= 8;
+      out |= static_cast<uint8_t>( peek().front() );
       input_.remove_prefix( 1 );
+    }
+  }
+
+  // Decode the next N bytes with `decode( const char* )`. The bytes are read straight out of the current
+  // buffer when it holds all of them, and are only gathered into a temporary when they straddle buffers.
+  template<size_t N, class F>
+  void fixed( F&& decode )
+  {
+    check_size( N );
+    if ( has_error() ) {
       return;
-    } else {
-      out = static_cast<T>( 0 );
-      for ( size_t i = 0; i < sizeof( T ); i++ ) {
-        out <<= 8;
-        out |= static_cast<uint8_t>( input_.peek().front() );
-        input_.remove_prefix( 1 );
-      }
     }
+
+    if ( peek().size() >= N ) {
+      decode( peek().data() );
+      input_.remove_prefix( N );
+      return;
+    }
+
+    std::array<char, N> scratch {};
+    string( scratch );
+    decode( scratch.data() );
   }
 
   void string( std::span<char> out )
@@ -158,79 +106,124 @@ public:
 
     auto next = out.begin();
     while ( next != out.end() ) {
-      const auto view = input_.peek().substr( 0, out.end() - next );
+      const auto view = peek().substr( 0, out.end() - next );
       next = std::copy( view.begin(), view.end(), next );
       input_.remove_prefix( view.size() );
     }
   }
 
-  void all_remaining( std::vector<std::string>& out ) { input_.dump_all( out ); }
-  void all_remaining( std::string& out ) { input_.dump_all( out ); }
-  std::vector<std::string_view> buffer() const { return input_.buffer(); }
+  // Hand over the rest of the input (sharing its Buffers, not copying bytes)
+  void all_remaining( BufferList& out ) { out = std::exchange( input_, {} ); }
+  void all_remaining( Buffer& out )
+  {
+    out = input_.coalesce();
+    input_ = {};
+  }
+  const BufferList& buffer() const { return input_; }
 };
 
 class Serializer
 {
-  std::vector<std::string> output_ {};
+  BufferList output_ {};
   std::string buffer_ {};
+  BufferArena* arena_ {}; // if set, header bytes are written here instead of into buffer_
 
 public:
   Serializer() = default;
   explicit Serializer( std::string&& buffer ) : buffer_( std::move( buffer ) ) {}
 
+  // Write header bytes into a reusable arena (which must outlive the Serializer), so that
+  // serializing a packet does not allocate a fresh string for its headers
+  explicit Serializer( BufferArena& arena ) : arena_( &arena ) {}
+
+  Serializer( const Serializer& other ) = default;
+  Serializer& operator=( const Serializer& other ) = default;
+  Serializer( Serializer&& other ) = default;
+  Serializer& operator=( Serializer&& other ) = default;
+  ~Serializer() = default;
+
   template<std::unsigned_integral T>
   void integer( const T val )
   {
-    constexpr uint64_t len = sizeof( T );
+    fixed<sizeof( T )>( [&]( char* p ) {
+      for ( size_t i = 0; i < sizeof( T ); ++i ) {
+        p[i] = static_cast<char>( val >> ( ( sizeof( T ) - i - 1 ) * 8 ) );
+      }
+    } );
+  }
 
-    for ( uint64_t i = 0; i < len; ++i ) {
-      const uint8_t byte_val = val >> ( ( len - i - 1 ) * 8 );
-      buffer_.push_back( byte_val );
+  // Encode N bytes in place with `encode( char* )`; the bytes start out zeroed
+  template<size_t N, class F>
+  void fixed( F&& encode )
+  {
+    if ( arena_ ) {
+      encode( arena_->extend( N ) );
+      return;
     }
+
+    const size_t start = buffer_.size();
+    buffer_.resize( start + N );
+    encode( buffer_.data() + start );
   }
 
-  void buffer( std::string buf )
+  void buffer( Buffer buf )
   {
     flush();
-    if ( not buf.empty() ) {
-      output_.push_back( std::move( buf ) );
-    }
+    output_.append( std::move( buf ) );
   }
 
-  void buffer( const std::vector<std::string>& bufs )
+  void buffer( const BufferList& bufs )
   {
-    for ( const auto& b : bufs ) {
-      buffer( b );
-    }
+    flush();
+    output_.append( bufs );
   }
 
   void flush()
   {
+    if ( arena_ and arena_->pending() ) {
+      output_.append( arena_->take() );
+    }
     if ( not buffer_.empty() ) {
-      output_.emplace_back( std::move( buffer_ ) );
+      output_.append( std::move( buffer_ ) );
       buffer_.clear();
     }
   }
 
-  const std::vector<std::string>& output()
+  const BufferList& output()
   {
     flush();
     return output_;
   }
+
+  // Move the output out of the Serializer (leaving it empty)
+  BufferList finish()
+  {
+    flush();
+    return std::exchange( output_, {} );
+  }
 };
 
 // Helper to serialize any object (without constructing a Serializer of the caller's own)
 template<class T>
-std::vector<std::string> serialize( const T& obj )
+BufferList serialize( const T& obj )
 {
   Serializer s;
   obj.serialize( s );
-  return s.output();
+  return s.finish();
+}
+
+// Helper to serialize any object, writing its headers into a reusable arena
+template<class T>
+BufferList serialize( const T& obj, BufferArena& arena )
+{
+  Serializer s { arena };
+  obj.serialize( s );
+  return s.finish();
 }
 
 // Helper to parse any object (without constructing a Parser of the caller's own). Returns true if successful.
 template<class T, typename... Targs>
-bool parse( T& obj, const std::vector<std::string>& buffers, Targs&&... Fargs )
+bool parse( T& obj, const BufferList& buffers, Targs&&... Fargs )
 {
   Parser p { buffers };
   obj.parse( p, std::forward<Targs>( Fargs )... );
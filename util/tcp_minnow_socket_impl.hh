@@ -105,10 +105,8 @@ void TCPMinnowSocket<AdaptT>::_initialize_TCP( const TCPConfig& config )
     _thread_data,
     Direction::In,
     [&] {
-      std::string data;
-      data.resize( _tcp->outbound_writer().available_capacity() );
-      _thread_data.read( data );
-      _tcp->outbound_writer().push( move( data ) );
+      Writer& outbound = _tcp->outbound_writer();
+      outbound.commit( _thread_data.read( outbound.reserve( outbound.available_capacity() ) ) );
 
       if ( _thread_data.eof() ) {
         _tcp->outbound_writer().close();
@@ -147,8 +145,7 @@ void TCPMinnowSocket<AdaptT>::_initialize_TCP( const TCPConfig& config )
       // the pipe, handling the possibility of a partial
       // write (i.e., only pop what was actually written).
       if ( inbound.bytes_buffered() ) {
-        const std::string_view buffer = inbound.peek();
-        const auto bytes_written = _thread_data.write( buffer );
+        const auto bytes_written = _thread_data.write( inbound.peek_all() );
         inbound.pop( bytes_written );
       }
 
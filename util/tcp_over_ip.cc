@@ -88,9 +88,10 @@ InternetDatagram TCPOverIPv4Adapter::wrap_tcp_in_ip( const TCPMessage& msg )
   ip_dgram.header.len = ip_dgram.header.hlen * 4 + 20 /* tcp header len */ + seg.message.sender.payload.size();
 
   // set payload, calculating TCP checksum using information from IP header
-  seg.compute_checksum( ip_dgram.header.pseudo_checksum() );
+  Serializer serializer { arena_ };
+  seg.serialize_with_checksum( serializer, ip_dgram.header.pseudo_checksum() );
   ip_dgram.header.compute_checksum();
-  ip_dgram.payload = serialize( seg );
+  ip_dgram.payload = serializer.finish();
 
   return ip_dgram;
 }
@@ -9,6 +9,11 @@
 //! \brief A converter from TCP segments to serialized IPv4 datagrams
 class TCPOverIPv4Adapter : public FdAdapterBase
 {
+  BufferArena arena_ {}; // reusable space for the headers of outgoing datagrams
+
+protected:
+  BufferArena& arena() { return arena_; }
+
 public:
   std::optional<TCPMessage> unwrap_tcp_in_ip( const InternetDatagram& ip_dgram );
 
@@ -65,7 +65,7 @@ public:
     need_send_ |= ( our_ackno.has_value() and msg.sender.seqno + 1 == our_ackno.value() );
 
     // Did the inbound stream finish before the outbound stream? If so, no need to linger after streams finish.
-    if ( receiver_.writer().is_closed() and not sender_.reader().is_finished() ) {
+    if ( receiver_.writer().is_closed() and not sender_.finished_sending() ) {
       linger_after_streams_finish_ = false;
     }
 
@@ -1,13 +1,45 @@
 #include "tcp_segment.hh"
 #include "checksum.hh"
+#include "header_layout.hh"
 #include "wrapping_integers.hh"
 
+#include <array>
 #include <cstddef>
 
 static constexpr uint32_t TCPHeaderMinLen = 5; // 32-bit words
 
 using namespace std;
 
+namespace {
+// TCP header fields (RFC 9293), as bit offsets from the start of the header
+using SourcePort = wire::Field<0, 16>;
+using DestinationPort = wire::Field<16, 16>;
+using SequenceNumber = wire::Field<32, 32>;
+using AcknowledgmentNumber = wire::Field<64, 32>;
+using DataOffset = wire::Field<96, 4>;
+using ACKFlag = wire::Field<107, 1>;
+using RSTFlag = wire::Field<109, 1>;
+using SYNFlag = wire::Field<110, 1>;
+using FINFlag = wire::Field<111, 1>;
+using Window = wire::Field<112, 16>;
+using Checksum = wire::Field<128, 16>;
+using UrgentPointer = wire::Field<144, 16>;
+
+using Layout = wire::Layout<TCPHeaderMinLen * 4,
+                            SourcePort,
+                            DestinationPort,
+                            SequenceNumber,
+                            AcknowledgmentNumber,
+                            DataOffset,
+                            ACKFlag,
+                            RSTFlag,
+                            SYNFlag,
+                            FINFlag,
+                            Window,
+                            Checksum,
+                            UrgentPointer>;
+} // namespace
+
 void TCPSegment::parse( Parser& parser, uint32_t datagram_layer_pseudo_checksum )
 {
   /* verify checksum */
@@ -18,34 +50,32 @@ void TCPSegment::parse( Parser& parser, uint32_t datagram_layer_pseudo_checksum
     return;
   }
 
-  uint32_t raw32 {};
-  uint16_t raw16 {};
-  uint8_t octet {};
-
-  parser.integer( udinfo.src_port );
-  parser.integer( udinfo.dst_port );
-
-  parser.integer( raw32 );
-  message.sender.seqno = Wrap32 { raw32 };
-
-  parser.integer( raw32 );
-  message.receiver.ackno = Wrap32 { raw32 };
-
-  parser.integer( octet );
-  const uint8_t data_offset = octet >> 4;
-
-  parser.integer( octet ); // flags
-  if ( not( octet & 0b0001'0000 ) ) {
+  uint32_t seqno {};
+  uint32_t ackno {};
+  uint8_t data_offset {};
+  bool ack {};
+  uint16_t urgent {};
+
+  Layout::parse( parser,
+                 udinfo.src_port,
+                 udinfo.dst_port,
+                 seqno,
+                 ackno,
+                 data_offset,
+                 ack,
+                 message.sender.RST,
+                 message.sender.SYN,
+                 message.sender.FIN,
+                 message.receiver.window_size,
+                 udinfo.cksum,
+                 urgent );
+
+  message.sender.seqno = Wrap32 { seqno };
+  message.receiver.ackno = Wrap32 { ackno };
+  if ( not ack ) {
     message.receiver.ackno.reset(); // no ACK
   }
-
-  message.sender.RST = message.receiver.RST = octet & 0b0000'0100;
-  message.sender.SYN = octet & 0b0000'0010;
-  message.sender.FIN = octet & 0b0000'0001;
-
-  parser.integer( message.receiver.window_size );
-  parser.integer( udinfo.cksum );
-  parser.integer( raw16 ); // urgent pointer
+  message.receiver.RST = message.sender.RST;
 
   // skip any options or anything extra in the header
   if ( data_offset < TCPHeaderMinLen ) {
@@ -62,30 +92,53 @@ public:
   uint32_t raw_value() const { return raw_value_; }
 };
 
+// Write the (option-less) header into `header`
+static void store_header( const TCPSegment& seg, char* header )
+{
+  const TCPMessage& message = seg.message;
+  Layout::store( header,
+                 seg.udinfo.src_port,
+                 seg.udinfo.dst_port,
+                 Wrap32Serializable { message.sender.seqno }.raw_value(),
+                 Wrap32Serializable { message.receiver.ackno.value_or( Wrap32 { 0 } ) }.raw_value(),
+                 TCPHeaderMinLen,
+                 message.receiver.ackno.has_value(),
+                 message.sender.RST or message.receiver.RST,
+                 message.sender.SYN,
+                 message.sender.FIN,
+                 message.receiver.window_size,
+                 seg.udinfo.cksum,
+                 uint16_t { 0 } );
+}
+
 void TCPSegment::serialize( Serializer& serializer ) const
 {
-  serializer.integer( udinfo.src_port );
-  serializer.integer( udinfo.dst_port );
-  serializer.integer( Wrap32Serializable { message.sender.seqno }.raw_value() );
-  serializer.integer( Wrap32Serializable { message.receiver.ackno.value_or( Wrap32 { 0 } ) }.raw_value() );
-  serializer.integer( uint8_t { TCPHeaderMinLen << 4 } ); // data offset
-  const bool reset = message.sender.RST or message.receiver.RST;
-  const uint8_t flags = ( message.receiver.ackno.has_value() ? 0b0001'0000U : 0 ) | ( reset ? 0b0000'0100U : 0 )
-                        | ( message.sender.SYN ? 0b0000'0010U : 0 ) | ( message.sender.FIN ? 0b0000'0001U : 0 );
-  serializer.integer( flags );
-  serializer.integer( message.receiver.window_size );
-  serializer.integer( udinfo.cksum );
-  serializer.integer( uint16_t { 0 } ); // urgent pointer
+  serializer.fixed<Layout::LENGTH>( [&]( char* header ) { store_header( *this, header ); } );
   serializer.buffer( message.sender.payload );
 }
 
-void TCPSegment::compute_checksum( uint32_t datagram_layer_pseudo_checksum )
+// Write the header into `header` with the correct checksum, summing the payload where it lies
+static void store_checksummed_header( TCPSegment& seg, char* header, uint32_t datagram_layer_pseudo_checksum )
 {
-  udinfo.cksum = 0;
-  Serializer s;
-  serialize( s );
+  seg.udinfo.cksum = 0;
+  store_header( seg, header );
 
   InternetChecksum check { datagram_layer_pseudo_checksum };
-  check.add( s.output() );
-  udinfo.cksum = check.value();
+  check.add( string_view { header, Layout::LENGTH } );
+  check.add( seg.message.sender.payload );
+  seg.udinfo.cksum = check.value();
+  Checksum::set( header, seg.udinfo.cksum );
+}
+
+void TCPSegment::compute_checksum( uint32_t datagram_layer_pseudo_checksum )
+{
+  array<char, Layout::LENGTH> header {};
+  store_checksummed_header( *this, header.data(), datagram_layer_pseudo_checksum );
+}
+
+void TCPSegment::serialize_with_checksum( Serializer& serializer, uint32_t datagram_layer_pseudo_checksum )
+{
+  serializer.fixed<Layout::LENGTH>(
+    [&]( char* header ) { store_checksummed_header( *this, header, datagram_layer_pseudo_checksum ); } );
+  serializer.buffer( message.sender.payload );
 }
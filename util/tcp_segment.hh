@@ -20,4 +20,8 @@ struct TCPSegment
   void serialize( Serializer& serializer ) const;
 
   void compute_checksum( uint32_t datagram_layer_pseudo_checksum );
+
+  // Serialize the segment, computing its checksum along the way (equivalent to compute_checksum()
+  // followed by serialize(), but the header is only written once)
+  void serialize_with_checksum( Serializer& serializer, uint32_t datagram_layer_pseudo_checksum );
 };
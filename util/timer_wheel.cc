@@ -0,0 +1,94 @@
+#include "timer_wheel.hh"
+
+#include <algorithm>
+#include <bit>
+#include <limits>
+
+using namespace std;
+
+void TimerWheel::schedule( const uint64_t deadline, const uint32_t id, const uint32_t cookie )
+{
+  insert( { deadline, id, cookie } );
+  ++size_;
+}
+
+void TimerWheel::insert( const Timer& timer )
+{
+  if ( timer.deadline <= now_ ) {
+    due_.push_back( timer );
+    return;
+  }
+
+  // the finest level whose higher bits agree with the current time
+  for ( size_t level = 0; level < LEVELS; ++level ) {
+    const size_t shift = BITS * ( level + 1 );
+    if ( ( timer.deadline >> shift ) == ( now_ >> shift ) ) {
+      const size_t slot = ( timer.deadline >> ( BITS * level ) ) & ( SLOTS - 1 );
+      levels_[level].slots[slot].push_back( timer );
+      levels_[level].occupied |= uint64_t { 1 } << slot;
+      return;
+    }
+  }
+
+  overflow_.push_back( timer );
+}
+
+uint64_t TimerWheel::next_event() const
+{
+  if ( not due_.empty() ) {
+    return now_;
+  }
+
+  uint64_t ret = numeric_limits<uint64_t>::max();
+  for ( size_t level = 0; level < LEVELS; ++level ) {
+    if ( levels_[level].occupied ) {
+      // every occupied slot on a level lies ahead of the current one, in the current rotation
+      const size_t shift = BITS * ( level + 1 );
+      const uint64_t slot = countr_zero( levels_[level].occupied );
+      ret = min( ret, ( now_ >> shift << shift ) | slot << ( BITS * level ) );
+    }
+  }
+
+  if ( not overflow_.empty() ) {
+    const size_t shift = BITS * LEVELS;
+    ret = min( ret, ( ( now_ >> shift ) + 1 ) << shift );
+  }
+
+  return ret;
+}
+
+void TimerWheel::take_due()
+{
+  scratch_.clear();
+
+  // collect everything due at now_ first (coarser levels cascade into finer ones, possibly into the
+  // current level-0 slot), then split it into expired timers and ones that still have time to go
+  cascade_.clear();
+  swap( cascade_, due_ );
+
+  for ( size_t level = 0; level < LEVELS; ++level ) {
+    const size_t slot = ( now_ >> ( BITS * level ) ) & ( SLOTS - 1 );
+    const uint64_t bit = uint64_t { 1 } << slot;
+    const size_t shift = BITS * level;
+    if ( ( levels_[level].occupied & bit ) and ( now_ & ( ( uint64_t { 1 } << shift ) - 1 ) ) == 0 ) {
+      auto& timers = levels_[level].slots[slot];
+      cascade_.insert( cascade_.end(), timers.begin(), timers.end() );
+      timers.clear();
+      levels_[level].occupied &= ~bit;
+    }
+  }
+
+  if ( not overflow_.empty() and ( now_ & ( ( uint64_t { 1 } << ( BITS * LEVELS ) ) - 1 ) ) == 0 ) {
+    cascade_.insert( cascade_.end(), overflow_.begin(), overflow_.end() );
+    overflow_.clear();
+  }
+
+  for ( const Timer& timer : cascade_ ) {
+    if ( timer.deadline <= now_ ) {
+      scratch_.push_back( timer );
+      --size_;
+    } else {
+      insert( timer );
+    }
+  }
+}
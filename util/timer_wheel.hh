@@ -0,0 +1,85 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+// A hierarchical timer wheel (Varghese & Lauck, "Hashed and Hierarchical Timing Wheels", 1987), in milliseconds.
+//
+// Level L has 64 slots of 64^L ms each, and holds the timers whose deadlines agree with the current time in
+// every bit above the level's six. A timer therefore starts out on the coarsest level it needs and is moved
+// ("cascaded") to a finer one when its slot comes up, until it reaches level 0 and expires on the exact
+// millisecond. Advancing the clock jumps straight from one occupied slot to the next (found with a bitmap per
+// level), so it costs O(timers expired or cascaded), not O(time elapsed) or O(timers pending).
+//
+// Timers cannot be cancelled individually. Instead each carries an `id` and a `cookie` chosen by the owner,
+// who bumps the cookie when rescheduling and ignores expirations whose cookie is stale.
+class TimerWheel
+{
+public:
+  struct Timer
+  {
+    uint64_t deadline;
+    uint32_t id;
+    uint32_t cookie;
+  };
+
+  // Current time, in ms
+  uint64_t now() const { return now_; }
+
+  // Number of timers that have not expired yet (including ones the owner considers cancelled)
+  size_t size() const { return size_; }
+
+  // Add a timer. A deadline that has already passed expires on the next advance().
+  void schedule( uint64_t deadline, uint32_t id, uint32_t cookie );
+
+  // Move the clock forward to `now`, calling `expire( id, cookie )` for every timer whose deadline has come,
+  // in order of deadline. `expire` may schedule more timers.
+  template<class F>
+  void advance( uint64_t now, F&& expire )
+  {
+    while ( true ) {
+      const uint64_t next = next_event();
+      if ( next > now ) {
+        break;
+      }
+      now_ = next;
+
+      take_due();
+      for ( const Timer& timer : scratch_ ) {
+        expire( timer.id, timer.cookie );
+      }
+    }
+    now_ = std::max( now_, now );
+  }
+
+private:
+  static constexpr size_t LEVELS = 4;
+  static constexpr size_t BITS = 6; // 64 slots per level, so the levels span 2^24 ms (about 4.6 hours)
+  static constexpr size_t SLOTS = size_t { 1 } << BITS;
+
+  struct Level
+  {
+    uint64_t occupied {}; // bit j is set if slot j holds any timers
+    std::array<std::vector<Timer>, SLOTS> slots {};
+  };
+
+  uint64_t now_ {};
+  size_t size_ {};
+  std::array<Level, LEVELS> levels_ {};
+  std::vector<Timer> due_ {};      // deadline already passed
+  std::vector<Timer> overflow_ {}; // beyond the top level
+  std::vector<Timer> cascade_ {};  // timers whose slot comes up in the current step
+  std::vector<Timer> scratch_ {};  // timers expiring in the current step
+
+  void insert( const Timer& timer );
+
+  // The earliest time at which a slot needs to be expired or cascaded (UINT64_MAX if none)
+  uint64_t next_event() const;
+
+  // Expire or cascade every slot that is due at now_, leaving the expired timers in scratch_
+  void take_due();
+};
@@ -10,8 +10,7 @@ optional<TCPMessage> TCPOverIPv4OverTunFdAdapter::read()
   _tun.read( strs );
 
   InternetDatagram ip_dgram;
-  const vector<string> buffers = { strs.at( 0 ), strs.at( 1 ) };
-  if ( parse( ip_dgram, buffers ) ) {
+  if ( parse( ip_dgram, BufferList { std::move( strs ) } ) ) {
     return unwrap_tcp_in_ip( ip_dgram );
   }
   return {};
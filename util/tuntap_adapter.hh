@@ -29,7 +29,7 @@ public:
   std::optional<TCPMessage> read();
 
   //! Creates an IPv4 datagram from a TCP segment and writes it to the TUN device
-  void write( const TCPMessage& seg ) { _tun.write( serialize( wrap_tcp_in_ip( seg ) ) ); }
+  void write( const TCPMessage& seg ) { _tun.write( serialize( wrap_tcp_in_ip( seg ), arena() ) ); }
 
   //! Access the underlying TUN device
   explicit operator TunFD&() { return _tun; }